@@ -0,0 +1,120 @@
+//
+// Allocators for large numeric buffers: over-aligned heap storage and transparent hugepage regions
+//
+
+#ifndef CPP_UTILS_ALIGNEDALLOCATOR_H
+#define CPP_UTILS_ALIGNEDALLOCATOR_H
+
+#include <cstdint>
+#include <cstdlib> // size_t
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+template<typename T, size_t Alignment = 64>
+class AlignedAllocator {
+    static_assert(Alignment >= alignof(T), "AlignedAllocator requires Alignment >= alignof(T)");
+    static_assert((Alignment & (Alignment - 1)) == 0, "AlignedAllocator requires a power of two Alignment");
+
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+    T *allocate(const size_t &n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T *ptr, const size_t &) noexcept {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return false;
+    }
+};
+
+#ifdef __linux__
+
+// Anonymous mappings aligned and rounded to 2 MiB, advised for transparent hugepages, meant for large
+// long-lived buffers
+template<typename T>
+class HugePageAllocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    static constexpr size_t PAGE_SIZE = size_t(2) << 20;
+
+    template<typename U>
+    struct rebind {
+        using other = HugePageAllocator<U>;
+    };
+
+    HugePageAllocator() noexcept = default;
+
+    template<typename U>
+    HugePageAllocator(const HugePageAllocator<U> &) noexcept {}
+
+    // mmap only aligns to the base page size, so map one huge page more and trim the unaligned head and tail: a
+    // buffer that does not start on a 2 MiB boundary cannot be backed by huge pages at its ends
+    T *allocate(const size_t &n) {
+        const size_t size = mapping_size(n);
+        void *ptr = mmap(nullptr, size + PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char *mapped = static_cast<char *>(ptr);
+        const size_t head = (PAGE_SIZE - uintptr_t(mapped) % PAGE_SIZE) % PAGE_SIZE;
+        if (head > 0) {
+            munmap(mapped, head);
+        }
+        munmap(mapped + head + size, PAGE_SIZE - head);
+        char *aligned = mapped + head;
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+        return reinterpret_cast<T *>(aligned);
+    }
+
+    void deallocate(T *ptr, const size_t &n) noexcept {
+        munmap(ptr, mapping_size(n));
+    }
+
+    template<typename U>
+    bool operator==(const HugePageAllocator<U> &) const noexcept {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const HugePageAllocator<U> &) const noexcept {
+        return false;
+    }
+
+private:
+    static size_t mapping_size(const size_t &n) {
+        return (n * sizeof(T) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    }
+};
+
+#endif
+
+#endif //CPP_UTILS_ALIGNEDALLOCATOR_H
@@ -0,0 +1,445 @@
+//
+// Lock-free skip list for concurrent producers and consumers of a priority queue
+//
+// Towers are linked with CAS and nodes are deleted logically first, by marking the low bit of their next pointers,
+// then unlinked by whichever traversal meets them. Equal keys are ordered by insertion sequence, so every node has
+// a unique position and each removal knows exactly where to look. Unlinked nodes are reclaimed once every thread
+// has moved past the epoch in which they were retired.
+//
+
+#ifndef CPP_UTILS_CONCURRENTSKIPLIST_H
+#define CPP_UTILS_CONCURRENTSKIPLIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace concurrent_detail {
+
+    // Epoch-based reclamation: a pointer retired in epoch e is freed once the global epoch reaches e + 2
+    class EpochReclaimer {
+    public:
+        static constexpr size_t SLOTS = 128;
+        static constexpr size_t COLLECT_THRESHOLD = 64;
+
+        // Pins the calling thread to the current epoch for the lifetime of the guard
+        class Guard {
+        public:
+            explicit Guard(EpochReclaimer &reclaimer) : _reclaimer(reclaimer), _slot(reclaimer.enter()) {}
+
+            Guard(const Guard &) = delete;
+
+            Guard &operator=(const Guard &) = delete;
+
+            ~Guard() {
+                _reclaimer.exit(_slot);
+            }
+
+            void retire(void *ptr) {
+                _reclaimer.retire(_slot, ptr);
+            }
+
+        private:
+            EpochReclaimer &_reclaimer;
+            size_t _slot;
+        };
+
+        explicit EpochReclaimer(void (*deleter)(void *)) : _deleter(deleter) {}
+
+        EpochReclaimer(const EpochReclaimer &) = delete;
+
+        EpochReclaimer &operator=(const EpochReclaimer &) = delete;
+
+        // Frees everything still retired, no thread may be pinned
+        ~EpochReclaimer() {
+            for (Slot &slot : _slots) {
+                for (const std::pair<uint64_t, void *> &retired : slot._retired) {
+                    _deleter(retired.second);
+                }
+            }
+        }
+
+    private:
+        static constexpr uint64_t IDLE = ~uint64_t(0);
+
+        struct alignas(64) Slot {
+            std::atomic<bool> _busy{false};
+            std::atomic<uint64_t> _epoch{IDLE};
+            // Only touched by the thread holding the slot
+            std::vector<std::pair<uint64_t, void *>> _retired = {};
+        };
+
+        size_t enter() {
+            static thread_local size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id()) % SLOTS;
+            size_t slot = hint;
+            while (true) {
+                bool expected = false;
+                if (!_slots[slot]._busy.load(std::memory_order_relaxed) &&
+                    _slots[slot]._busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    break;
+                }
+                slot = (slot + 1) % SLOTS;
+                if (slot == hint) {
+                    std::this_thread::yield();
+                }
+            }
+            hint = slot;
+            _slots[slot]._epoch.store(_global.load());
+            return slot;
+        }
+
+        void exit(const size_t &slot) {
+            _slots[slot]._epoch.store(IDLE, std::memory_order_release);
+            _slots[slot]._busy.store(false, std::memory_order_release);
+        }
+
+        void retire(const size_t &slot, void *ptr) {
+            std::vector<std::pair<uint64_t, void *>> &retired = _slots[slot]._retired;
+            retired.emplace_back(_global.load(), ptr);
+            if (retired.size() < COLLECT_THRESHOLD) {
+                return;
+            }
+            try_advance();
+            const uint64_t global = _global.load();
+            size_t kept = 0;
+            for (const std::pair<uint64_t, void *> &entry : retired) {
+                if (entry.first + 2 <= global) {
+                    _deleter(entry.second);
+                } else {
+                    retired[kept++] = entry;
+                }
+            }
+            retired.resize(kept);
+        }
+
+        // Moves to the next epoch if every pinned thread has observed the current one
+        void try_advance() {
+            uint64_t global = _global.load();
+            for (const Slot &slot : _slots) {
+                const uint64_t epoch = slot._epoch.load();
+                if (epoch != IDLE && epoch != global) {
+                    return;
+                }
+            }
+            _global.compare_exchange_strong(global, global + 1);
+        }
+
+        void (*_deleter)(void *);
+        alignas(64) std::atomic<uint64_t> _global{0};
+        Slot _slots[SLOTS];
+    };
+
+    // Per-thread xorshift64 stream
+    inline uint64_t thread_random() {
+        static thread_local uint64_t state =
+                (0x9e3779b97f4a7c15ull ^ std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+}
+
+template<typename T, typename V>
+class ConcurrentSkipList {
+private:
+    static constexpr size_t MAX_LEVEL = 32;
+
+    // Low bit set: the owning node is logically deleted at that level
+    using Link = std::atomic<uintptr_t>;
+
+    static constexpr uintptr_t MARK = 1;
+
+    static bool is_marked(const uintptr_t &link) {
+        return (link & MARK) != 0;
+    }
+
+    class Node;
+
+    static Node *pointer(const uintptr_t &link) {
+        return reinterpret_cast<Node *>(link & ~MARK);
+    }
+
+    // Header of a node, its tower of _height links follows it in the same allocation
+    class Node {
+    public:
+        Node(const T &data, const V &val, const uint64_t &seq, const size_t &height) : _data(data), _val(val),
+                                                                                       _seq(seq), _height(height) {}
+
+        ~Node() = default;
+
+        Link &next(const size_t &level) {
+            return tower(this)[level];
+        }
+
+        static Link *tower(Node *node) {
+            return reinterpret_cast<Link *>(reinterpret_cast<char *>(node) + TOWER_OFFSET);
+        }
+
+        // Strict order on (key, insertion sequence)
+        bool before(const V &val, const uint64_t &seq) const {
+            return _val < val || (!(val < _val) && _seq < seq);
+        }
+
+        T _data;
+        V _val;
+        uint64_t _seq;
+        size_t _height;
+        // The inserter and the remover each drop one reference once they no longer link the node
+        std::atomic<int> _owners{2};
+    };
+
+    static constexpr size_t TOWER_OFFSET = (sizeof(Node) + alignof(Link) - 1) / alignof(Link) * alignof(Link);
+
+public:
+    ConcurrentSkipList() : _reclaimer(&ConcurrentSkipList::free_node) {
+        for (Link &link : _head) {
+            link.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    // No other thread may use the list anymore
+    ~ConcurrentSkipList() {
+        Node *tmp = pointer(_head[0].load(std::memory_order_relaxed));
+        while (tmp != nullptr) {
+            Node *next = pointer(tmp->next(0).load(std::memory_order_relaxed));
+            free_node(tmp);
+            tmp = next;
+        }
+    }
+
+    // Set before the list is shared between threads
+    ConcurrentSkipList &set_ratio(const int &ratio) {
+        _ratio = ratio;
+        return *this;
+    }
+
+    // Upper bound on how many live minimums a relaxed pop may skip
+    ConcurrentSkipList &set_spread(const size_t &spread) {
+        _spread = spread;
+        return *this;
+    }
+
+    // Add, Pop
+    void add(const T &data, const V &val) {
+        concurrent_detail::EpochReclaimer::Guard guard(_reclaimer);
+        const uint64_t seq = _sequence.fetch_add(1, std::memory_order_relaxed);
+        const size_t height = random_height();
+        raise_level(height);
+        Node *node = create_node(data, val, seq, height);
+
+        Link *preds[MAX_LEVEL];
+        Node *succs[MAX_LEVEL];
+        while (true) {
+            find(val, seq, preds, succs);
+            node->next(0).store(reinterpret_cast<uintptr_t>(succs[0]), std::memory_order_relaxed);
+            uintptr_t expected = reinterpret_cast<uintptr_t>(succs[0]);
+            if (preds[0][0].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(node),
+                                                  std::memory_order_release, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        _size.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t level = 1; level < height; ++level) {
+            while (true) {
+                uintptr_t current = node->next(level).load(std::memory_order_acquire);
+                if (is_marked(current)) {
+                    // Being removed, stop raising the tower
+                    level = height;
+                    break;
+                }
+                if (pointer(current) != succs[level] &&
+                    !node->next(level).compare_exchange_strong(current, reinterpret_cast<uintptr_t>(succs[level]),
+                                                               std::memory_order_acq_rel)) {
+                    continue;
+                }
+                uintptr_t expected = reinterpret_cast<uintptr_t>(succs[level]);
+                if (preds[level][level].compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(node),
+                                                          std::memory_order_release, std::memory_order_relaxed)) {
+                    break;
+                }
+                find(val, seq, preds, succs);
+            }
+        }
+
+        // A remover may have searched before the upper links above were published
+        if (is_marked(node->next(0).load(std::memory_order_acquire))) {
+            find(val, seq, preds, succs);
+        }
+        release(guard, node);
+    }
+
+    // Removes the minimum into data, returns false if the list was empty
+    bool try_pop(T &data) {
+        return pop_after(data, 0);
+    }
+
+    // Removes one of the first spread live nodes, chosen at random, so that concurrent consumers do not all
+    // contend on the minimum. Falls back to the minimum when fewer nodes remain.
+    bool try_pop_relaxed(T &data) {
+        const size_t skip = _spread > 1 ? size_t(concurrent_detail::thread_random() % _spread) : 0;
+        return pop_after(data, skip) || (skip > 0 && pop_after(data, 0));
+    }
+
+    bool contains(const V &val) {
+        concurrent_detail::EpochReclaimer::Guard guard(_reclaimer);
+        Link *preds[MAX_LEVEL];
+        Node *succs[MAX_LEVEL];
+        find(val, 0, preds, succs);
+        for (Node *node = succs[0]; node != nullptr && !(val < node->_val);
+             node = pointer(node->next(0).load(std::memory_order_acquire))) {
+            if (!is_marked(node->next(0).load(std::memory_order_acquire))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Exact when no operation is in flight
+    size_t size() const {
+        const ptrdiff_t size = _size.load(std::memory_order_relaxed);
+        return size < 0 ? 0 : size_t(size);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    // Fills preds/succs with the links around (val, seq) at every level, unlinking marked nodes on the way
+    void find(const V &val, const uint64_t &seq, Link **preds, Node **succs) {
+    retry:
+        Link *pred = _head;
+        const size_t top = _level.load(std::memory_order_acquire);
+        for (size_t level = MAX_LEVEL; level-- > 0;) {
+            if (level >= top) {
+                preds[level] = _head;
+                succs[level] = pointer(_head[level].load(std::memory_order_acquire));
+                continue;
+            }
+            Node *curr = pointer(pred[level].load(std::memory_order_acquire));
+            while (curr != nullptr) {
+                uintptr_t succ = curr->next(level).load(std::memory_order_acquire);
+                while (is_marked(succ)) {
+                    uintptr_t expected = reinterpret_cast<uintptr_t>(curr);
+                    if (!pred[level].compare_exchange_strong(expected, succ & ~MARK, std::memory_order_acq_rel)) {
+                        goto retry;
+                    }
+                    curr = pointer(succ);
+                    if (curr == nullptr) {
+                        break;
+                    }
+                    succ = curr->next(level).load(std::memory_order_acquire);
+                }
+                if (curr == nullptr || !curr->before(val, seq)) {
+                    break;
+                }
+                pred = Node::tower(curr);
+                curr = pointer(succ);
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+    }
+
+    // Claims the first live node after skip other live ones, then unlinks it
+    bool pop_after(T &data, size_t skip) {
+        concurrent_detail::EpochReclaimer::Guard guard(_reclaimer);
+        Node *curr = pointer(_head[0].load(std::memory_order_acquire));
+        while (curr != nullptr) {
+            uintptr_t succ = curr->next(0).load(std::memory_order_acquire);
+            if (is_marked(succ)) {
+                curr = pointer(succ);
+                continue;
+            }
+            if (skip > 0) {
+                skip--;
+                curr = pointer(succ);
+                continue;
+            }
+            // Upper levels are marked first so that the level 0 mark, which decides the winner, is the last one
+            for (size_t level = curr->_height; level-- > 1;) {
+                curr->next(level).fetch_or(MARK, std::memory_order_acq_rel);
+            }
+            while (!is_marked(succ)) {
+                if (curr->next(0).compare_exchange_weak(succ, succ | MARK, std::memory_order_acq_rel)) {
+                    data = curr->_data;
+                    _size.fetch_sub(1, std::memory_order_relaxed);
+                    Link *preds[MAX_LEVEL];
+                    Node *succs[MAX_LEVEL];
+                    find(curr->_val, curr->_seq, preds, succs);
+                    release(guard, curr);
+                    return true;
+                }
+            }
+            curr = pointer(succ);
+        }
+        return false;
+    }
+
+    size_t random_height() const {
+        size_t height = 1;
+        while (height < MAX_LEVEL && concurrent_detail::thread_random() % uint64_t(_ratio) == 0) {
+            height++;
+        }
+        return height;
+    }
+
+    void raise_level(const size_t &height) {
+        size_t level = _level.load(std::memory_order_relaxed);
+        while (level < height && !_level.compare_exchange_weak(level, height, std::memory_order_acq_rel)) {
+        }
+    }
+
+    Node *create_node(const T &data, const V &val, const uint64_t &seq, const size_t &height) {
+        void *memory = ::operator new(TOWER_OFFSET + height * sizeof(Link));
+        Node *node;
+        try {
+            node = new(memory) Node(data, val, seq, height);
+        } catch (...) {
+            ::operator delete(memory);
+            throw;
+        }
+        Link *tower = Node::tower(node);
+        for (size_t level = 0; level < height; ++level) {
+            new(tower + level) Link(0);
+        }
+        return node;
+    }
+
+    static void free_node(void *memory) {
+        Node *node = static_cast<Node *>(memory);
+        Link *tower = Node::tower(node);
+        for (size_t level = 0; level < node->_height; ++level) {
+            tower[level].~Link();
+        }
+        node->~Node();
+        ::operator delete(memory);
+    }
+
+    void release(concurrent_detail::EpochReclaimer::Guard &guard, Node *node) {
+        if (node->_owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            guard.retire(node);
+        }
+    }
+
+    Link _head[MAX_LEVEL];
+    std::atomic<size_t> _level{1};
+    std::atomic<uint64_t> _sequence{1};
+    std::atomic<ptrdiff_t> _size{0};
+    int _ratio = 4;
+    size_t _spread = 1;
+    concurrent_detail::EpochReclaimer _reclaimer;
+};
+
+#endif //CPP_UTILS_CONCURRENTSKIPLIST_H
@@ -6,21 +6,122 @@
 #ifndef CPP_UTILS_MATRIX_H
 #define CPP_UTILS_MATRIX_H
 
+#include <cstddef>
 #include <cstdlib> // size_t
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "AlignedAllocator.hpp"
+#include "MatrixExpression.hpp"
+#include "MatrixView.hpp"
 
 template<typename T>
-class Matrix {
+class MappedMatrix;
+
+// Mapping modes of Matrix::map_file, copy-on-write pages become private to the process when written
+enum class MatrixMapMode {
+    ReadOnly,
+    CopyOnWrite
+};
+
+// Contiguous random-access iterator over Matrix storage, a thin wrapper around a pointer
+template<typename E>
+class MatrixIterator {
+public:
+#if __cplusplus >= 202002L
+    using iterator_concept = std::contiguous_iterator_tag;
+#endif
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_const_t<E>;
+    using element_type = E;
+    using difference_type = ptrdiff_t;
+    using pointer = E *;
+    using reference = E &;
+
+    MatrixIterator() = default;
+    explicit MatrixIterator(E *ptr);
+    template<typename M>
+    MatrixIterator(M *mat, const size_t &val);
+    template<typename U, typename = std::enable_if_t<std::is_same<const U, E>::value && !std::is_same<U, E>::value>>
+    MatrixIterator(const MatrixIterator<U> &other);
+    MatrixIterator(const MatrixIterator &other) = default;
+    MatrixIterator(MatrixIterator &&other) noexcept = default;
+    MatrixIterator &operator=(const MatrixIterator &other) = default;
+    MatrixIterator &operator=(MatrixIterator &&other) noexcept = default;
+    ~MatrixIterator() = default;
+
+    MatrixIterator &operator++();
+    MatrixIterator operator++(int);
+    MatrixIterator &operator--();
+    MatrixIterator operator--(int);
+    MatrixIterator &operator+=(const difference_type &n);
+    MatrixIterator &operator-=(const difference_type &n);
+    MatrixIterator operator+(const difference_type &n) const;
+    MatrixIterator operator-(const difference_type &n) const;
+    difference_type operator-(const MatrixIterator &other) const;
+
+    bool operator==(const MatrixIterator &other) const;
+    bool operator!=(const MatrixIterator &other) const;
+    bool operator<(const MatrixIterator &other) const;
+    bool operator>(const MatrixIterator &other) const;
+    bool operator<=(const MatrixIterator &other) const;
+    bool operator>=(const MatrixIterator &other) const;
+
+    E &operator*() const;
+    E *operator->() const;
+    E &operator[](const difference_type &n) const;
+
+    friend MatrixIterator operator+(const difference_type &n, const MatrixIterator &it) {
+        return it + n;
+    }
+
+private:
+    template<typename U>
+    friend class MatrixIterator;
+
+    E *ptr = nullptr;
+};
+
+template<typename T, typename Allocator = AlignedAllocator<T>>
+class Matrix : public MatrixExpression<Matrix<T, Allocator>> {
 public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
+    // Tag for the constructor leaving elements uninitialized, for buffers overwritten right away
+    struct Uninitialized {
+    };
+    static constexpr Uninitialized uninitialized = {};
+
     Matrix() = default;
-    Matrix(const size_t &width, const size_t &height);
-    Matrix(const Matrix<T> &other);
-    Matrix(Matrix<T> &&other) noexcept;
-    Matrix(const size_t &width, const size_t &height, const T *valTab);
-    Matrix(const size_t &width, const size_t &height, const T val);
-    Matrix<T> &operator=(const Matrix<T> &other);
-    Matrix<T> &operator=(Matrix<T> &&other) noexcept;
+    explicit Matrix(const Allocator &alloc);
+    Matrix(const size_t &width, const size_t &height, const Allocator &alloc = Allocator());
+    Matrix(const size_t &width, const size_t &height, Uninitialized, const Allocator &alloc = Allocator());
+    Matrix(const Matrix<T, Allocator> &other);
+    Matrix(Matrix<T, Allocator> &&other) noexcept;
+    Matrix(const size_t &width, const size_t &height, const T *valTab, const Allocator &alloc = Allocator());
+    Matrix(const size_t &width, const size_t &height, const T val, const Allocator &alloc = Allocator());
+    // Implicit only when the element type of expr converts to T without narrowing
+    template<typename E, matrix_detail::enable_if_implicit_t<E, T> = 0>
+    Matrix(const MatrixExpression<E> &expr, const Allocator &alloc = Allocator());
+    template<typename E, matrix_detail::enable_if_explicit_t<E, T> = 0>
+    explicit Matrix(const MatrixExpression<E> &expr, const Allocator &alloc = Allocator());
+    Matrix<T, Allocator> &operator=(const Matrix<T, Allocator> &other);
+    Matrix<T, Allocator> &operator=(Matrix<T, Allocator> &&other) noexcept;
+    template<typename E>
+    Matrix<T, Allocator> &operator=(const MatrixExpression<E> &expr);
     ~Matrix();
 
+    template<typename E>
+    Matrix<T, Allocator> &operator+=(const MatrixExpression<E> &expr);
+    template<typename E>
+    Matrix<T, Allocator> &operator-=(const MatrixExpression<E> &expr);
+    Matrix<T, Allocator> &operator*=(const T &val);
+    Matrix<T, Allocator> &operator/=(const T &val);
+
     const T &at(const size_t &x, const size_t &y) const;
     T &at(const size_t &x, const size_t &y);
 
@@ -34,268 +135,539 @@ public:
     T *get_data();
     const T *get_data() const;
 
-    class Iterator {
-    public:
-        Iterator(Matrix<T> *mat, const size_t &val);
-        Iterator(const Iterator &other) = default;
-        Iterator(Iterator &&other) noexcept = default;
-        Iterator &operator=(const Iterator &other) = default;
-        Iterator &operator=(Iterator &&other) noexcept = default;
-        ~Iterator() = default;
-
-        Iterator &operator++();
-        Iterator operator++(int);
-        bool operator==(const Iterator &other) const;
-        bool operator!=(const Iterator &other) const;
-        T &operator*();
-        T *operator->();
-
-    private:
-        Matrix<T> *mat;
-        size_t val = {};
-    };
+    bool aliases(const matrix_detail::StorageRegion &region) const;
 
-    class Const_Iterator {
-    public:
-        Const_Iterator(const Matrix<T> *mat, const size_t &val);
-        Const_Iterator(const Const_Iterator &other) = default;
-        Const_Iterator(Const_Iterator &&other) = default;
-        Const_Iterator &operator=(const Const_Iterator &other) = default;
-        Const_Iterator &operator=(Const_Iterator &&other) = default;
-        ~Const_Iterator() = default;
-
-        Const_Iterator &operator++();
-        Const_Iterator operator++(int);
-        bool operator==(const Const_Iterator &other) const;
-        bool operator!=(const Const_Iterator &other) const;
-        const T &operator*();
-        const T *operator->();
-
-    private:
-        const Matrix<T> *mat;
-        size_t val = {};
-    };
+    Allocator get_allocator() const;
+
+    MatrixView<T> view();
+    ConstMatrixView<T> view() const;
+    MatrixView<T> view(const size_t &x0, const size_t &y0, const size_t &w, const size_t &h);
+    ConstMatrixView<T> view(const size_t &x0, const size_t &y0, const size_t &w, const size_t &h) const;
+    MatrixView<T> row(const size_t &y);
+    ConstMatrixView<T> row(const size_t &y) const;
+    MatrixView<T> column(const size_t &x);
+    ConstMatrixView<T> column(const size_t &x) const;
+    MatrixView<T> transposed();
+    ConstMatrixView<T> transposed() const;
+
+    operator MatrixView<T>();
+    operator ConstMatrixView<T>() const;
+
+    // Maps a file written by save_matrix or MatrixWriter, defined in MatrixFile.hpp
+    static MappedMatrix<T> map_file(const std::string &path, const MatrixMapMode &mode = MatrixMapMode::ReadOnly);
+
+    using Iterator = MatrixIterator<T>;
+    using Const_Iterator = MatrixIterator<const T>;
+    using iterator = Iterator;
+    using const_iterator = Const_Iterator;
 
     Iterator begin();
     Const_Iterator begin() const;
     Iterator end();
     Const_Iterator end() const;
+    Const_Iterator cbegin() const;
+    Const_Iterator cend() const;
+    size_t size() const;
 
 private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+
     size_t width = 0;
     size_t height = 0;
     size_t surface = 0;
     T *data = nullptr;
+    Allocator alloc = {};
+
+    // Storage an expression is about to overwrite, left uninitialized unless T requires construction
+    using trivial_element = std::integral_constant<bool, std::is_trivially_default_constructible<T>::value &&
+                                                         std::is_trivially_destructible<T>::value>;
+    Matrix(const size_t &width, const size_t &height, std::true_type, const Allocator &alloc);
+    Matrix(const size_t &width, const size_t &height, std::false_type, const Allocator &alloc);
+
+    void allocate_storage();
+    void release_storage();
+
+    template<typename E, typename Op>
+    void evaluate(const MatrixExpression<E> &expr, Op op);
 };
 
 // Functions definitions
 
-template<typename T>
-Matrix<T>::Matrix(const size_t &width, const size_t &height) : width(width), height(height), surface(height * width),
-                                                               data(new T[width * height]) {}
+template<typename E>
+MatrixIterator<E>::MatrixIterator(E *ptr) : ptr(ptr) {}
 
-template<typename T>
-Matrix<T>::Matrix(const Matrix<T> &other) : width(other.width), height(other.height), surface(other.surface),
-                                            data(new T[other.width * other.height]) {
+template<typename E>
+template<typename M>
+MatrixIterator<E>::MatrixIterator(M *mat, const size_t &val) : ptr(mat->get_data() + val) {}
+
+template<typename E>
+template<typename U, typename>
+MatrixIterator<E>::MatrixIterator(const MatrixIterator<U> &other) : ptr(other.ptr) {}
+
+template<typename E>
+MatrixIterator<E> &MatrixIterator<E>::operator++() {
+    ++ptr;
+    return *this;
+}
+
+template<typename E>
+MatrixIterator<E> MatrixIterator<E>::operator++(int) {
+    MatrixIterator old(*this);
+    ++ptr;
+    return old;
+}
+
+template<typename E>
+MatrixIterator<E> &MatrixIterator<E>::operator--() {
+    --ptr;
+    return *this;
+}
+
+template<typename E>
+MatrixIterator<E> MatrixIterator<E>::operator--(int) {
+    MatrixIterator old(*this);
+    --ptr;
+    return old;
+}
+
+template<typename E>
+MatrixIterator<E> &MatrixIterator<E>::operator+=(const difference_type &n) {
+    ptr += n;
+    return *this;
+}
+
+template<typename E>
+MatrixIterator<E> &MatrixIterator<E>::operator-=(const difference_type &n) {
+    ptr -= n;
+    return *this;
+}
+
+template<typename E>
+MatrixIterator<E> MatrixIterator<E>::operator+(const difference_type &n) const {
+    return MatrixIterator(ptr + n);
+}
+
+template<typename E>
+MatrixIterator<E> MatrixIterator<E>::operator-(const difference_type &n) const {
+    return MatrixIterator(ptr - n);
+}
+
+template<typename E>
+typename MatrixIterator<E>::difference_type MatrixIterator<E>::operator-(const MatrixIterator &other) const {
+    return ptr - other.ptr;
+}
+
+template<typename E>
+bool MatrixIterator<E>::operator==(const MatrixIterator &other) const {
+    return ptr == other.ptr;
+}
+
+template<typename E>
+bool MatrixIterator<E>::operator!=(const MatrixIterator &other) const {
+    return ptr != other.ptr;
+}
+
+template<typename E>
+bool MatrixIterator<E>::operator<(const MatrixIterator &other) const {
+    return ptr < other.ptr;
+}
+
+template<typename E>
+bool MatrixIterator<E>::operator>(const MatrixIterator &other) const {
+    return ptr > other.ptr;
+}
+
+template<typename E>
+bool MatrixIterator<E>::operator<=(const MatrixIterator &other) const {
+    return ptr <= other.ptr;
+}
+
+template<typename E>
+bool MatrixIterator<E>::operator>=(const MatrixIterator &other) const {
+    return ptr >= other.ptr;
+}
+
+template<typename E>
+E &MatrixIterator<E>::operator*() const {
+    return *ptr;
+}
+
+template<typename E>
+E *MatrixIterator<E>::operator->() const {
+    return ptr;
+}
+
+template<typename E>
+E &MatrixIterator<E>::operator[](const difference_type &n) const {
+    return ptr[n];
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const Allocator &alloc) : alloc(alloc) {}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const size_t &width, const size_t &height, const Allocator &alloc) : width(width),
+                                                                                                  height(height),
+                                                                                                  surface(height * width),
+                                                                                                  alloc(alloc) {
+    allocate_storage();
+#pragma omp parallel for default(none) shared(surface)
+    for (size_t i = 0; i < surface; ++i) {
+        alloc_traits::construct(this->alloc, data + i);
+    }
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const size_t &width, const size_t &height, Uninitialized, const Allocator &alloc)
+        : width(width), height(height), surface(height * width), alloc(alloc) {
+    static_assert(std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value,
+                  "Matrix(width, height, uninitialized) requires a trivial element type");
+    allocate_storage();
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const size_t &width, const size_t &height, std::true_type, const Allocator &alloc)
+        : Matrix(width, height, uninitialized, alloc) {}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const size_t &width, const size_t &height, std::false_type, const Allocator &alloc)
+        : Matrix(width, height, alloc) {}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const Matrix<T, Allocator> &other)
+        : width(other.width), height(other.height), surface(other.surface),
+          alloc(alloc_traits::select_on_container_copy_construction(other.alloc)) {
+    allocate_storage();
 #pragma omp parallel for default(none) shared(other, surface)
     for (size_t i = 0; i < surface; ++i) {
-        data[i] = other.data[i];
+        alloc_traits::construct(alloc, data + i, other.data[i]);
     }
 }
 
-template<typename T>
-Matrix<T>::Matrix(Matrix<T> &&other) noexcept : width(other.width), height(other.height), surface(other.surface),
-                                                data(other.data) {
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(Matrix<T, Allocator> &&other) noexcept : width(other.width), height(other.height),
+                                                                      surface(other.surface), data(other.data),
+                                                                      alloc(std::move(other.alloc)) {
+    other.width = 0;
+    other.height = 0;
+    other.surface = 0;
     other.data = nullptr;
 }
 
-template<typename T>
-Matrix<T>::Matrix(const size_t &width, const size_t &height, const T *valTab) : width(width), height(height),
-                                                                                surface(height * width),
-                                                                                data(new T[width * height]) {
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const size_t &width, const size_t &height, const T *valTab, const Allocator &alloc)
+        : width(width), height(height), surface(height * width), alloc(alloc) {
+    allocate_storage();
 #pragma omp parallel for default(none) shared(valTab, surface)
     for (size_t i = 0; i < surface; ++i) {
-        data[i] = valTab[i];
+        alloc_traits::construct(this->alloc, data + i, valTab[i]);
     }
 }
 
-template<typename T>
-Matrix<T>::Matrix(const size_t &width, const size_t &height, const T val) : width(width), height(height),
-                                                                            surface(height * width),
-                                                                            data(new T[width * height]) {
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::Matrix(const size_t &width, const size_t &height, const T val, const Allocator &alloc)
+        : width(width), height(height), surface(height * width), alloc(alloc) {
+    allocate_storage();
 #pragma omp parallel for default(none) shared(val, surface)
     for (size_t i = 0; i < surface; ++i) {
-        data[i] = val;
+        alloc_traits::construct(this->alloc, data + i, val);
     }
 }
 
-template<typename T>
-Matrix<T> &Matrix<T>::operator=(const Matrix<T> &other) {
+template<typename T, typename Allocator>
+template<typename E, matrix_detail::enable_if_implicit_t<E, T>>
+Matrix<T, Allocator>::Matrix(const MatrixExpression<E> &expr, const Allocator &alloc)
+        : Matrix(expr.get_width(), expr.get_height(), trivial_element(), alloc) {
+    evaluate(expr, [](T &dst, const auto &val) { dst = val; });
+}
+
+template<typename T, typename Allocator>
+template<typename E, matrix_detail::enable_if_explicit_t<E, T>>
+Matrix<T, Allocator>::Matrix(const MatrixExpression<E> &expr, const Allocator &alloc)
+        : Matrix(expr.get_width(), expr.get_height(), trivial_element(), alloc) {
+    evaluate(expr, [](T &dst, const auto &val) { dst = T(val); });
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator> &Matrix<T, Allocator>::operator=(const Matrix<T, Allocator> &other) {
     if (&other != this) {
+        const bool propagate = alloc_traits::propagate_on_container_copy_assignment::value && alloc != other.alloc;
+        if (surface != other.surface || propagate) {
+            release_storage();
+            if (alloc_traits::propagate_on_container_copy_assignment::value) {
+                alloc = other.alloc;
+            }
+            surface = other.surface;
+            allocate_storage();
+#pragma omp parallel for default(none) shared(other, surface)
+            for (size_t i = 0; i < surface; ++i) {
+                alloc_traits::construct(alloc, data + i, other.data[i]);
+            }
+        } else {
+            // Same surface: reuse the buffer instead of going through the allocator
+#pragma omp parallel for default(none) shared(other, surface)
+            for (size_t i = 0; i < surface; ++i) {
+                data[i] = other.data[i];
+            }
+        }
         width = other.width;
         height = other.height;
-        surface = other.surface;
-        delete[] data;
-        data = new T[surface];
-#pragma omp parallel for default(none) shared(other, surface)
-        for (size_t i = 0; i < surface; ++i) {
-            data[i] = other.data[i];
+    }
+    return *this;
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator> &Matrix<T, Allocator>::operator=(Matrix<T, Allocator> &&other) noexcept {
+    if (&other != this) {
+        if (alloc_traits::propagate_on_container_move_assignment::value || alloc == other.alloc) {
+            release_storage();
+            if (alloc_traits::propagate_on_container_move_assignment::value) {
+                alloc = std::move(other.alloc);
+            }
+            width = other.width;
+            height = other.height;
+            surface = other.surface;
+            data = other.data;
+            other.width = 0;
+            other.height = 0;
+            other.surface = 0;
+            other.data = nullptr;
+        } else {
+            *this = static_cast<const Matrix<T, Allocator> &>(other);
         }
     }
     return *this;
 }
 
-template<typename T>
-Matrix<T> &Matrix<T>::operator=(Matrix<T> &&other) noexcept {
-    width = other.width;
-    height = other.height;
-    surface = other.surface;
-    delete[] data;
-    data = other.data;
-    other.data = nullptr;
+template<typename T, typename Allocator>
+template<typename E>
+Matrix<T, Allocator> &Matrix<T, Allocator>::operator=(const MatrixExpression<E> &expr) {
+    if (expr.get_width() != width || expr.get_height() != height) {
+        // Evaluate before releasing storage, the expression may reference this matrix
+        *this = Matrix<T, Allocator>(expr, alloc);
+        return *this;
+    }
+    evaluate(expr, [](T &dst, const auto &val) { dst = val; });
     return *this;
 }
 
-template<typename T>
-Matrix<T>::~Matrix() {
-    delete[] data;
+template<typename T, typename Allocator>
+template<typename E>
+Matrix<T, Allocator> &Matrix<T, Allocator>::operator+=(const MatrixExpression<E> &expr) {
+    if (expr.get_width() != width || expr.get_height() != height) {
+        throw std::invalid_argument("Matrix<T, Allocator> &Matrix<T, Allocator>::operator+=(expr) requires expr of the same dimensions");
+    }
+    evaluate(expr, [](T &dst, const auto &val) { dst += val; });
+    return *this;
 }
 
-template<typename T>
-const T &Matrix<T>::at(const size_t &x, const size_t &y) const {
+template<typename T, typename Allocator>
+template<typename E>
+Matrix<T, Allocator> &Matrix<T, Allocator>::operator-=(const MatrixExpression<E> &expr) {
+    if (expr.get_width() != width || expr.get_height() != height) {
+        throw std::invalid_argument("Matrix<T, Allocator> &Matrix<T, Allocator>::operator-=(expr) requires expr of the same dimensions");
+    }
+    evaluate(expr, [](T &dst, const auto &val) { dst -= val; });
+    return *this;
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator> &Matrix<T, Allocator>::operator*=(const T &val) {
+#pragma omp parallel for default(none) shared(val, surface)
+    for (size_t i = 0; i < surface; ++i) {
+        data[i] *= val;
+    }
+    return *this;
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator> &Matrix<T, Allocator>::operator/=(const T &val) {
+#pragma omp parallel for default(none) shared(val, surface)
+    for (size_t i = 0; i < surface; ++i) {
+        data[i] /= val;
+    }
+    return *this;
+}
+
+// Single fused pass over the destination, rows distributed across threads
+template<typename T, typename Allocator>
+template<typename E, typename Op>
+void Matrix<T, Allocator>::evaluate(const MatrixExpression<E> &expr, Op op) {
+    matrix_detail::evaluate_safely(data, width, height, ptrdiff_t(width), 1, expr.self(), op);
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::~Matrix() {
+    release_storage();
+}
+
+template<typename T, typename Allocator>
+void Matrix<T, Allocator>::allocate_storage() {
+    data = surface > 0 ? alloc_traits::allocate(alloc, surface) : nullptr;
+}
+
+template<typename T, typename Allocator>
+void Matrix<T, Allocator>::release_storage() {
+    if (data != nullptr) {
+        if (!std::is_trivially_destructible<T>::value) {
+            for (size_t i = 0; i < surface; ++i) {
+                alloc_traits::destroy(alloc, data + i);
+            }
+        }
+        alloc_traits::deallocate(alloc, data, surface);
+        data = nullptr;
+    }
+}
+
+template<typename T, typename Allocator>
+const T &Matrix<T, Allocator>::at(const size_t &x, const size_t &y) const {
     return data[x + y * width];
 }
 
-template<typename T>
-T &Matrix<T>::at(const size_t &x, const size_t &y) {
+template<typename T, typename Allocator>
+T &Matrix<T, Allocator>::at(const size_t &x, const size_t &y) {
     return data[x + y * width];
 }
 
-template<typename T>
-const T &Matrix<T>::at(const size_t &i) const {
+template<typename T, typename Allocator>
+const T &Matrix<T, Allocator>::at(const size_t &i) const {
     return data[i];
 }
 
-template<typename T>
-T &Matrix<T>::at(const size_t &i) {
+template<typename T, typename Allocator>
+T &Matrix<T, Allocator>::at(const size_t &i) {
     return data[i];
 }
 
-template<typename T>
-size_t Matrix<T>::get_width() const {
+template<typename T, typename Allocator>
+size_t Matrix<T, Allocator>::get_width() const {
     return width;
 }
 
-template<typename T>
-size_t Matrix<T>::get_height() const {
+template<typename T, typename Allocator>
+size_t Matrix<T, Allocator>::get_height() const {
     return height;
 }
 
-template<typename T>
-size_t Matrix<T>::get_surface() const {
+template<typename T, typename Allocator>
+size_t Matrix<T, Allocator>::get_surface() const {
     return surface;
 }
 
-template<typename T>
-T *Matrix<T>::get_data() {
+template<typename T, typename Allocator>
+T *Matrix<T, Allocator>::get_data() {
     return data;
 }
 
-template<typename T>
-const T *Matrix<T>::get_data() const {
+template<typename T, typename Allocator>
+const T *Matrix<T, Allocator>::get_data() const {
     return data;
 }
 
-template<typename T>
-Matrix<T>::Iterator::Iterator(Matrix<T> *mat, const size_t &val) : mat(mat), val(val) {}
+template<typename T, typename Allocator>
+bool Matrix<T, Allocator>::aliases(const matrix_detail::StorageRegion &region) const {
+    return matrix_detail::regions_conflict(region, {data, width, height, ptrdiff_t(width), 1, sizeof(T)});
+}
 
-template<typename T>
-typename Matrix<T>::Iterator &Matrix<T>::Iterator::operator++() {
-    ++val;
-    return *this;
+template<typename T, typename Allocator>
+Allocator Matrix<T, Allocator>::get_allocator() const {
+    return alloc;
 }
 
-template<typename T>
-typename Matrix<T>::Iterator Matrix<T>::Iterator::operator++(int) {
-    Iterator old(*this);
-    ++val;
-    return old;
+template<typename T, typename Allocator>
+MatrixView<T> Matrix<T, Allocator>::view() {
+    return MatrixView<T>(data, width, height, ptrdiff_t(width));
 }
 
-template<typename T>
-bool Matrix<T>::Iterator::operator==(const Iterator &other) const {
-    return (mat == other.mat && val == other.val);
+template<typename T, typename Allocator>
+ConstMatrixView<T> Matrix<T, Allocator>::view() const {
+    return ConstMatrixView<T>(data, width, height, ptrdiff_t(width));
 }
 
-template<typename T>
-bool Matrix<T>::Iterator::operator!=(const Iterator &other) const {
-    return (mat != other.mat || val != other.val);
+template<typename T, typename Allocator>
+MatrixView<T> Matrix<T, Allocator>::view(const size_t &x0, const size_t &y0, const size_t &w, const size_t &h) {
+    return view().view(x0, y0, w, h);
 }
 
-template<typename T>
-T &Matrix<T>::Iterator::operator*() {
-    return mat->at(val);
+template<typename T, typename Allocator>
+ConstMatrixView<T> Matrix<T, Allocator>::view(const size_t &x0, const size_t &y0,
+                                              const size_t &w, const size_t &h) const {
+    return view().view(x0, y0, w, h);
 }
 
-template<typename T>
-T *Matrix<T>::Iterator::operator->() {
-    return &(mat->at(val));
+template<typename T, typename Allocator>
+MatrixView<T> Matrix<T, Allocator>::row(const size_t &y) {
+    return view().row(y);
 }
 
-template<typename T>
-Matrix<T>::Const_Iterator::Const_Iterator(const Matrix<T> *mat, const size_t &val) : mat(mat), val(val) {}
+template<typename T, typename Allocator>
+ConstMatrixView<T> Matrix<T, Allocator>::row(const size_t &y) const {
+    return view().row(y);
+}
 
-template<typename T>
-typename Matrix<T>::Const_Iterator &Matrix<T>::Const_Iterator::operator++() {
-    ++val;
-    return *this;
+template<typename T, typename Allocator>
+MatrixView<T> Matrix<T, Allocator>::column(const size_t &x) {
+    return view().column(x);
 }
 
-template<typename T>
-typename Matrix<T>::Const_Iterator Matrix<T>::Const_Iterator::operator++(int) {
-    Const_Iterator old(*this);
-    ++val;
-    return old;
+template<typename T, typename Allocator>
+ConstMatrixView<T> Matrix<T, Allocator>::column(const size_t &x) const {
+    return view().column(x);
 }
 
-template<typename T>
-bool Matrix<T>::Const_Iterator::operator==(const Const_Iterator &other) const {
-    return (mat == other.mat && val == other.val);
+template<typename T, typename Allocator>
+MatrixView<T> Matrix<T, Allocator>::transposed() {
+    return view().transposed();
 }
 
-template<typename T>
-bool Matrix<T>::Const_Iterator::operator!=(const Const_Iterator &other) const {
-    return (mat != other.mat || val != other.val);
+template<typename T, typename Allocator>
+ConstMatrixView<T> Matrix<T, Allocator>::transposed() const {
+    return view().transposed();
 }
 
-template<typename T>
-const T &Matrix<T>::Const_Iterator::operator*() {
-    return mat->at(val);
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::operator MatrixView<T>() {
+    return view();
 }
 
-template<typename T>
-const T *Matrix<T>::Const_Iterator::operator->() {
-    return &(mat->at(val));
+template<typename T, typename Allocator>
+Matrix<T, Allocator>::operator ConstMatrixView<T>() const {
+    return view();
 }
 
-template<typename T>
-typename Matrix<T>::Iterator Matrix<T>::begin() {
-    return Iterator(this, 0);
+template<typename T, typename Allocator>
+typename Matrix<T, Allocator>::Iterator Matrix<T, Allocator>::begin() {
+    return Iterator(data);
 }
 
-template<typename T>
-typename Matrix<T>::Const_Iterator Matrix<T>::begin() const {
-    return Const_Iterator(this, 0);
+template<typename T, typename Allocator>
+typename Matrix<T, Allocator>::Const_Iterator Matrix<T, Allocator>::begin() const {
+    return Const_Iterator(data);
 }
 
-template<typename T>
-typename Matrix<T>::Iterator Matrix<T>::end() {
-    return Iterator(this, surface);
+template<typename T, typename Allocator>
+typename Matrix<T, Allocator>::Iterator Matrix<T, Allocator>::end() {
+    return Iterator(data + surface);
 }
 
-template<typename T>
-typename Matrix<T>::Const_Iterator Matrix<T>::end() const {
-    return Const_Iterator(this, surface);
+template<typename T, typename Allocator>
+typename Matrix<T, Allocator>::Const_Iterator Matrix<T, Allocator>::end() const {
+    return Const_Iterator(data + surface);
+}
+
+template<typename T, typename Allocator>
+typename Matrix<T, Allocator>::Const_Iterator Matrix<T, Allocator>::cbegin() const {
+    return begin();
+}
+
+template<typename T, typename Allocator>
+typename Matrix<T, Allocator>::Const_Iterator Matrix<T, Allocator>::cend() const {
+    return end();
+}
+
+template<typename T, typename Allocator>
+size_t Matrix<T, Allocator>::size() const {
+    return surface;
 }
 
 #endif //CPP_UTILS_MATRIX_H
@@ -0,0 +1,342 @@
+//
+// Parallel reductions and transforms over Matrix, MatrixView and MappedMatrix
+//
+// Every function takes anything with a view() member returning a MatrixView, and is only visible to overload
+// resolution for those. Rows are distributed across OpenMP threads, each thread reduces into its own partial
+// accumulator and partials are merged once per thread.
+//
+
+#ifndef CPP_UTILS_MATRIXALGORITHM_H
+#define CPP_UTILS_MATRIXALGORITHM_H
+
+#include <cstdlib> // size_t
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Matrix.hpp"
+
+template<typename T>
+struct MatrixExtremum {
+    size_t x;
+    size_t y;
+    T value;
+};
+
+namespace matrix_detail {
+
+    template<typename V>
+    struct is_matrix_view : std::false_type {
+    };
+
+    template<typename E>
+    struct is_matrix_view<BasicMatrixView<E>> : std::true_type {
+    };
+
+    template<typename M, typename = void>
+    struct has_view : std::false_type {
+    };
+
+    template<typename M>
+    struct has_view<M, std::void_t<decltype(std::declval<M &>().view())>>
+            : is_matrix_view<decltype(std::declval<M &>().view())> {
+    };
+
+    template<typename M>
+    using enable_if_viewable_t = std::enable_if_t<has_view<std::remove_reference_t<M>>::value, int>;
+
+    template<typename M>
+    using view_value_t = typename decltype(std::declval<M &>().view())::value_type;
+
+    template<typename M>
+    ConstMatrixView<view_value_t<M>> const_view(const M &mat) {
+        return mat.view();
+    }
+
+    // Destination matrix whose elements are all overwritten right away
+    template<typename T>
+    Matrix<T> make_output(const size_t &width, const size_t &height) {
+        if constexpr (std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value) {
+            return Matrix<T>(width, height, Matrix<T>::uninitialized);
+        } else {
+            return Matrix<T>(width, height);
+        }
+    }
+
+    // Reduces each row with row_op(acc, y, row pointer, width, col stride), then merges per-thread partials with
+    // combine. Every thread starts from init, which must be neutral for combine.
+    template<typename T, typename Acc, typename RowOp, typename Combine>
+    Acc reduce_rows(const ConstMatrixView<T> &mat, const Acc &init, RowOp row_op, Combine combine) {
+        Acc result = init;
+        const size_t height = mat.get_height();
+#pragma omp parallel default(none) shared(mat, init, row_op, combine, result, height)
+        {
+            Acc local = init;
+#pragma omp for schedule(static) nowait
+            for (size_t y = 0; y < height; ++y) {
+                local = row_op(std::move(local), y, &mat.at(0, y), mat.get_width(), mat.get_col_stride());
+            }
+#pragma omp critical
+            result = combine(std::move(result), std::move(local));
+        }
+        return result;
+    }
+
+    template<typename T, typename Compare>
+    MatrixExtremum<T> arg_extremum(const ConstMatrixView<T> &mat, Compare better) {
+        if (mat.get_surface() == 0) {
+            throw std::invalid_argument("argmin/argmax require a non-empty matrix");
+        }
+        using Best = std::pair<bool, MatrixExtremum<T>>;
+        const Best init = {false, {0, 0, mat.at(0, 0)}};
+        const Best best = reduce_rows(
+                mat, init,
+                [&better](Best acc, const size_t &y, const T *row, const size_t &width, const ptrdiff_t &stride) {
+                    for (size_t x = 0; x < width; ++x) {
+                        const T &val = row[ptrdiff_t(x) * stride];
+                        if (!acc.first || better(val, acc.second.value)) {
+                            acc = {true, {x, y, val}};
+                        }
+                    }
+                    return acc;
+                },
+                [&better](Best lhs, Best rhs) {
+                    if (!rhs.first) {
+                        return lhs;
+                    }
+                    if (!lhs.first || better(rhs.second.value, lhs.second.value)) {
+                        return rhs;
+                    }
+                    // Ties resolve to the first element in row-major order, whatever the thread schedule
+                    const bool earlier = rhs.second.y < lhs.second.y ||
+                                         (rhs.second.y == lhs.second.y && rhs.second.x < lhs.second.x);
+                    if (earlier && !better(lhs.second.value, rhs.second.value)) {
+                        return rhs;
+                    }
+                    return lhs;
+                });
+        return best.second;
+    }
+}
+
+// Generic parallel reduction: op(acc, value) folds an element into a partial, combine(acc, acc) merges two partials
+// and must be associative and commutative along with op. Every thread's partial starts from Acc(), which must be the
+// identity of combine, and init is folded exactly once, as combine(init, partial).
+template<typename M, typename Acc, typename Op, typename Combine, matrix_detail::enable_if_viewable_t<M> = 0>
+Acc reduce(const M &mat, const Acc &init, Op op, Combine combine) {
+    using T = matrix_detail::view_value_t<M>;
+    const Acc partial = matrix_detail::reduce_rows(
+            matrix_detail::const_view(mat), Acc(),
+            [&op](Acc acc, const size_t &, const T *row, const size_t &width, const ptrdiff_t &stride) {
+                for (size_t x = 0; x < width; ++x) {
+                    acc = op(std::move(acc), row[ptrdiff_t(x) * stride]);
+                }
+                return acc;
+            },
+            combine);
+    return combine(init, partial);
+}
+
+// Reduction where op also merges partials, so it must accept (Acc, Acc) as well as (Acc, value). Each thread's
+// partial starts from its first element converted to Acc, so no identity is needed and init is folded exactly once.
+template<typename M, typename Acc, typename Op, matrix_detail::enable_if_viewable_t<M> = 0>
+Acc reduce(const M &mat, const Acc &init, Op op) {
+    using T = matrix_detail::view_value_t<M>;
+    using Partial = std::optional<Acc>;
+    const Partial partial = matrix_detail::reduce_rows(
+            matrix_detail::const_view(mat), Partial(),
+            [&op](Partial acc, const size_t &, const T *row, const size_t &width, const ptrdiff_t &stride) {
+                size_t x = 0;
+                if (!acc && width > 0) {
+                    acc.emplace(row[0]);
+                    x = 1;
+                }
+                for (; x < width; ++x) {
+                    *acc = op(std::move(*acc), row[ptrdiff_t(x) * stride]);
+                }
+                return acc;
+            },
+            [&op](Partial lhs, Partial rhs) {
+                if (!lhs || !rhs) {
+                    return lhs ? lhs : rhs;
+                }
+                return Partial(op(std::move(*lhs), std::move(*rhs)));
+            });
+    return partial ? Acc(op(init, *partial)) : init;
+}
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+matrix_detail::view_value_t<M> sum(const M &mat) {
+    using T = matrix_detail::view_value_t<M>;
+    return matrix_detail::reduce_rows(
+            matrix_detail::const_view(mat), T(),
+            [](T acc, const size_t &, const T *row, const size_t &width, const ptrdiff_t &stride) {
+                if constexpr (std::is_arithmetic<T>::value) {
+                    if (stride == 1) {
+                        T row_sum = T();
+#pragma omp simd reduction(+ : row_sum)
+                        for (size_t x = 0; x < width; ++x) {
+                            row_sum += row[x];
+                        }
+                        return acc + row_sum;
+                    }
+                }
+                for (size_t x = 0; x < width; ++x) {
+                    acc += row[ptrdiff_t(x) * stride];
+                }
+                return acc;
+            },
+            [](const T &lhs, const T &rhs) { return lhs + rhs; });
+}
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+std::pair<matrix_detail::view_value_t<M>, matrix_detail::view_value_t<M>> minmax(const M &mat) {
+    using T = matrix_detail::view_value_t<M>;
+    const ConstMatrixView<T> view = matrix_detail::const_view(mat);
+    if (view.get_surface() == 0) {
+        throw std::invalid_argument("minmax(mat) requires a non-empty matrix");
+    }
+    using Range = std::pair<T, T>;
+    return matrix_detail::reduce_rows(
+            view, Range(view.at(0, 0), view.at(0, 0)),
+            [](Range acc, const size_t &, const T *row, const size_t &width, const ptrdiff_t &stride) {
+                T low = acc.first;
+                T high = acc.second;
+                if constexpr (std::is_arithmetic<T>::value) {
+                    if (stride == 1) {
+#pragma omp simd reduction(min : low) reduction(max : high)
+                        for (size_t x = 0; x < width; ++x) {
+                            low = row[x] < low ? row[x] : low;
+                            high = high < row[x] ? row[x] : high;
+                        }
+                        return Range(low, high);
+                    }
+                }
+                for (size_t x = 0; x < width; ++x) {
+                    const T &val = row[ptrdiff_t(x) * stride];
+                    low = val < low ? val : low;
+                    high = high < val ? val : high;
+                }
+                return Range(low, high);
+            },
+            [](const Range &lhs, const Range &rhs) {
+                return Range(rhs.first < lhs.first ? rhs.first : lhs.first,
+                             lhs.second < rhs.second ? rhs.second : lhs.second);
+            });
+}
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+matrix_detail::view_value_t<M> min_value(const M &mat) {
+    return minmax(mat).first;
+}
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+matrix_detail::view_value_t<M> max_value(const M &mat) {
+    return minmax(mat).second;
+}
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+MatrixExtremum<matrix_detail::view_value_t<M>> argmin(const M &mat) {
+    using T = matrix_detail::view_value_t<M>;
+    return matrix_detail::arg_extremum(matrix_detail::const_view(mat), [](const T &a, const T &b) { return a < b; });
+}
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+MatrixExtremum<matrix_detail::view_value_t<M>> argmax(const M &mat) {
+    using T = matrix_detail::view_value_t<M>;
+    return matrix_detail::arg_extremum(matrix_detail::const_view(mat), [](const T &a, const T &b) { return b < a; });
+}
+
+template<typename M, typename Predicate, matrix_detail::enable_if_viewable_t<M> = 0>
+size_t count_if(const M &mat, Predicate pred) {
+    using T = matrix_detail::view_value_t<M>;
+    return matrix_detail::reduce_rows(
+            matrix_detail::const_view(mat), size_t(0),
+            [&pred](size_t acc, const size_t &, const T *row, const size_t &width, const ptrdiff_t &stride) {
+                for (size_t x = 0; x < width; ++x) {
+                    acc += pred(row[ptrdiff_t(x) * stride]) ? 1 : 0;
+                }
+                return acc;
+            },
+            [](const size_t &lhs, const size_t &rhs) { return lhs + rhs; });
+}
+
+// Counts values in [low, high) into bins equal-width bins, values outside the range are ignored
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+std::vector<size_t> histogram(const M &mat, const size_t &bins,
+                              const matrix_detail::view_value_t<M> &low, const matrix_detail::view_value_t<M> &high) {
+    using T = matrix_detail::view_value_t<M>;
+    if (bins == 0 || !(low < high)) {
+        throw std::invalid_argument("histogram(mat, bins, low, high) requires bins > 0 and low < high");
+    }
+    const double scale = double(bins) / (double(high) - double(low));
+    return matrix_detail::reduce_rows(
+            matrix_detail::const_view(mat), std::vector<size_t>(bins, 0),
+            [&](std::vector<size_t> acc, const size_t &, const T *row, const size_t &width, const ptrdiff_t &stride) {
+                for (size_t x = 0; x < width; ++x) {
+                    const T &val = row[ptrdiff_t(x) * stride];
+                    if (!(val < low) && val < high) {
+                        const size_t bin = size_t((double(val) - double(low)) * scale);
+                        ++acc[bin < bins ? bin : bins - 1];
+                    }
+                }
+                return acc;
+            },
+            [](std::vector<size_t> lhs, const std::vector<size_t> &rhs) {
+                for (size_t i = 0; i < lhs.size(); ++i) {
+                    lhs[i] += rhs[i];
+                }
+                return lhs;
+            });
+}
+
+// dst(x, y) = f(src(x, y)), src and dst may be the same matrix
+template<typename Src, typename Dst, typename F, matrix_detail::enable_if_viewable_t<Src> = 0,
+         matrix_detail::enable_if_viewable_t<Dst> = 0>
+void transform(const Src &src, Dst &&dst, F f) {
+    const auto in = matrix_detail::const_view(src);
+    auto out = dst.view();
+    if (in.get_width() != out.get_width() || in.get_height() != out.get_height()) {
+        throw std::invalid_argument("transform(src, dst, f) requires src and dst of the same dimensions");
+    }
+    const size_t height = in.get_height();
+    const size_t width = in.get_width();
+#pragma omp parallel for default(none) shared(in, out, f, height, width)
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            out.at(x, y) = f(in.at(x, y));
+        }
+    }
+}
+
+// Calls f(x, y, value) with a mutable reference on every element
+template<typename M, typename F, matrix_detail::enable_if_viewable_t<M> = 0>
+void apply(M &&mat, F f) {
+    auto out = mat.view();
+    const size_t height = out.get_height();
+    const size_t width = out.get_width();
+#pragma omp parallel for default(none) shared(out, f, height, width)
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            f(x, y, out.at(x, y));
+        }
+    }
+}
+
+// Calls f(x, y, value) with a const reference on every element, f must be safe to call concurrently
+template<typename M, typename F, matrix_detail::enable_if_viewable_t<M> = 0>
+void for_each_indexed(const M &mat, F f) {
+    const auto in = matrix_detail::const_view(mat);
+    const size_t height = in.get_height();
+    const size_t width = in.get_width();
+#pragma omp parallel for default(none) shared(in, f, height, width)
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            f(x, y, in.at(x, y));
+        }
+    }
+}
+
+#endif //CPP_UTILS_MATRIXALGORITHM_H
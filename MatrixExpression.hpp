@@ -0,0 +1,309 @@
+//
+// Lazy element-wise Matrix arithmetic, evaluated in one pass on assignment
+//
+
+#ifndef CPP_UTILS_MATRIXEXPRESSION_H
+#define CPP_UTILS_MATRIXEXPRESSION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib> // size_t
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// CRTP base of everything usable in an element-wise expression.
+// Derived types provide get_width(), get_height() and at(x, y) const, and aliases(region) const telling whether they
+// read storage in region; expressions without it are assumed to and get evaluated through a temporary.
+// Expressions hold references to their Matrix leaves: build and assign them in the same statement.
+template<typename E>
+class MatrixExpression {
+public:
+    const E &self() const {
+        return static_cast<const E &>(*this);
+    }
+
+    size_t get_width() const {
+        return self().get_width();
+    }
+
+    size_t get_height() const {
+        return self().get_height();
+    }
+
+    decltype(auto) at(const size_t &x, const size_t &y) const {
+        return self().at(x, y);
+    }
+};
+
+template<typename E>
+struct is_matrix_expression : std::is_base_of<MatrixExpression<E>, E> {
+};
+
+namespace matrix_detail {
+
+    // Leaves that own storage are held by reference, intermediate nodes by value
+    template<typename E>
+    struct expression_storage {
+        using type = const E &;
+    };
+
+    template<typename E>
+    using expression_storage_t = typename expression_storage<E>::type;
+
+    template<typename E>
+    using expression_value_t = std::decay_t<decltype(std::declval<const E &>().at(0, 0))>;
+
+    // Strided storage, element (x, y) at data + y * row_stride + x * col_stride
+    struct StorageRegion {
+        const void *data;
+        size_t width;
+        size_t height;
+        ptrdiff_t row_stride;
+        ptrdiff_t col_stride;
+        size_t element_size;
+    };
+
+    // Bytes [first, last) spanned by a non-empty region
+    inline void storage_bounds(const StorageRegion &region, uintptr_t &first, uintptr_t &last) {
+        const ptrdiff_t last_row = ptrdiff_t(region.height - 1) * region.row_stride;
+        const ptrdiff_t last_col = ptrdiff_t(region.width - 1) * region.col_stride;
+        const auto size = ptrdiff_t(region.element_size);
+        first = uintptr_t(region.data) + uintptr_t((std::min<ptrdiff_t>(0, last_row) +
+                                                    std::min<ptrdiff_t>(0, last_col)) * size);
+        last = uintptr_t(region.data) + uintptr_t((std::max<ptrdiff_t>(0, last_row) +
+                                                   std::max<ptrdiff_t>(0, last_col) + 1) * size);
+    }
+
+    // Whether reading src while writing dst element by element may read an element already overwritten. Regions
+    // mapping every coordinate to the same element are safe: each element is read before being written.
+    inline bool regions_conflict(const StorageRegion &dst, const StorageRegion &src) {
+        if (dst.width == 0 || dst.height == 0 || src.width == 0 || src.height == 0) {
+            return false;
+        }
+        uintptr_t dst_first, dst_last, src_first, src_last;
+        storage_bounds(dst, dst_first, dst_last);
+        storage_bounds(src, src_first, src_last);
+        if (dst_last <= src_first || src_last <= dst_first) {
+            return false;
+        }
+        return dst.data != src.data || dst.element_size != src.element_size ||
+               dst.width != src.width || dst.height != src.height ||
+               (dst.height > 1 && dst.row_stride != src.row_stride) ||
+               (dst.width > 1 && dst.col_stride != src.col_stride);
+    }
+
+    template<typename E, typename = void>
+    struct has_aliases : std::false_type {
+    };
+
+    template<typename E>
+    struct has_aliases<E, std::void_t<decltype(std::declval<const E &>().aliases(std::declval<StorageRegion>()))>>
+            : std::true_type {
+    };
+
+    // Whether evaluating expr into region must go through a temporary
+    template<typename E>
+    bool aliases(const E &expr, const StorageRegion &region) {
+        if constexpr (has_aliases<E>::value) {
+            return expr.aliases(region);
+        } else {
+            return true;
+        }
+    }
+}
+
+template<typename L, typename R, typename Op>
+class MatrixBinaryExpression : public MatrixExpression<MatrixBinaryExpression<L, R, Op>> {
+public:
+    using value_type = std::decay_t<decltype(std::declval<Op>()(std::declval<matrix_detail::expression_value_t<L>>(),
+                                                                std::declval<matrix_detail::expression_value_t<R>>()))>;
+
+    MatrixBinaryExpression(const L &lhs, const R &rhs, Op op = Op()) : lhs(lhs), rhs(rhs), op(op) {
+        if (lhs.get_width() != rhs.get_width() || lhs.get_height() != rhs.get_height()) {
+            throw std::invalid_argument("MatrixBinaryExpression(lhs, rhs) requires operands of the same dimensions");
+        }
+    }
+
+    size_t get_width() const {
+        return lhs.get_width();
+    }
+
+    size_t get_height() const {
+        return lhs.get_height();
+    }
+
+    value_type at(const size_t &x, const size_t &y) const {
+        return op(lhs.at(x, y), rhs.at(x, y));
+    }
+
+    bool aliases(const matrix_detail::StorageRegion &region) const {
+        return matrix_detail::aliases(lhs, region) || matrix_detail::aliases(rhs, region);
+    }
+
+private:
+    matrix_detail::expression_storage_t<L> lhs;
+    matrix_detail::expression_storage_t<R> rhs;
+    Op op;
+};
+
+template<typename E, typename Op>
+class MatrixUnaryExpression : public MatrixExpression<MatrixUnaryExpression<E, Op>> {
+public:
+    using value_type = std::decay_t<decltype(std::declval<Op>()(std::declval<matrix_detail::expression_value_t<E>>()))>;
+
+    explicit MatrixUnaryExpression(const E &expr, Op op = Op()) : expr(expr), op(op) {}
+
+    size_t get_width() const {
+        return expr.get_width();
+    }
+
+    size_t get_height() const {
+        return expr.get_height();
+    }
+
+    value_type at(const size_t &x, const size_t &y) const {
+        return op(expr.at(x, y));
+    }
+
+    bool aliases(const matrix_detail::StorageRegion &region) const {
+        return matrix_detail::aliases(expr, region);
+    }
+
+private:
+    matrix_detail::expression_storage_t<E> expr;
+    Op op;
+};
+
+// Scalar broadcast to the dimensions of the other operand
+template<typename S>
+class MatrixConstant : public MatrixExpression<MatrixConstant<S>> {
+public:
+    using value_type = S;
+
+    MatrixConstant(const size_t &width, const size_t &height, const S &val) : width(width), height(height), val(val) {}
+
+    size_t get_width() const {
+        return width;
+    }
+
+    size_t get_height() const {
+        return height;
+    }
+
+    const S &at(const size_t &, const size_t &) const {
+        return val;
+    }
+
+    bool aliases(const matrix_detail::StorageRegion &) const {
+        return false;
+    }
+
+private:
+    size_t width;
+    size_t height;
+    S val;
+};
+
+namespace matrix_detail {
+
+    template<typename L, typename R, typename Op>
+    struct expression_storage<MatrixBinaryExpression<L, R, Op>> {
+        using type = MatrixBinaryExpression<L, R, Op>;
+    };
+
+    template<typename E, typename Op>
+    struct expression_storage<MatrixUnaryExpression<E, Op>> {
+        using type = MatrixUnaryExpression<E, Op>;
+    };
+
+    template<typename S>
+    struct expression_storage<MatrixConstant<S>> {
+        using type = MatrixConstant<S>;
+    };
+
+    template<typename S>
+    using enable_if_scalar_t = std::enable_if_t<!is_matrix_expression<S>::value, int>;
+
+    // Whether a V copy-list-initializes a T, which rules out narrowing and explicit constructors
+    template<typename V, typename T, typename = void>
+    struct is_non_narrowing : std::false_type {
+    };
+
+    template<typename V, typename T>
+    struct is_non_narrowing<V, T, std::void_t<decltype(std::declval<void (&)(T)>()({std::declval<V>()}))>>
+            : std::true_type {
+    };
+
+    // Whether V is what arithmetic on T promotes to, as int for char + char
+    template<typename V, typename T, typename = void>
+    struct is_promotion_of : std::false_type {
+    };
+
+    template<typename V, typename T>
+    struct is_promotion_of<V, T, std::enable_if_t<std::is_arithmetic<T>::value>>
+            : std::is_same<V, decltype(+std::declval<T>())> {
+    };
+
+    template<typename V, typename T>
+    struct converts_implicitly : std::integral_constant<bool, std::is_same<V, T>::value ||
+                                                              is_non_narrowing<V, T>::value ||
+                                                              is_promotion_of<V, T>::value> {
+    };
+
+    template<typename E, typename T>
+    using enable_if_implicit_t = std::enable_if_t<converts_implicitly<expression_value_t<E>, T>::value, int>;
+
+    template<typename E, typename T>
+    using enable_if_explicit_t = std::enable_if_t<!converts_implicitly<expression_value_t<E>, T>::value, int>;
+}
+
+// Element-wise operators
+
+template<typename L, typename R>
+MatrixBinaryExpression<L, R, std::plus<>> operator+(const MatrixExpression<L> &lhs, const MatrixExpression<R> &rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template<typename L, typename R>
+MatrixBinaryExpression<L, R, std::minus<>> operator-(const MatrixExpression<L> &lhs, const MatrixExpression<R> &rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template<typename E>
+MatrixUnaryExpression<E, std::negate<>> operator-(const MatrixExpression<E> &expr) {
+    return MatrixUnaryExpression<E, std::negate<>>(expr.self());
+}
+
+template<typename L, typename R>
+MatrixBinaryExpression<L, R, std::multiplies<>> hadamard(const MatrixExpression<L> &lhs,
+                                                        const MatrixExpression<R> &rhs) {
+    return {lhs.self(), rhs.self()};
+}
+
+template<typename E, typename Op>
+MatrixUnaryExpression<E, Op> map(const MatrixExpression<E> &expr, Op op) {
+    return MatrixUnaryExpression<E, Op>(expr.self(), op);
+}
+
+#define CPP_UTILS_MATRIX_SCALAR_OPERATOR(OP, FUNCTOR)                                                                \
+    template<typename E, typename S, matrix_detail::enable_if_scalar_t<S> = 0>                                         \
+    MatrixBinaryExpression<E, MatrixConstant<S>, FUNCTOR> operator OP(const MatrixExpression<E> &expr, const S &val) { \
+        return {expr.self(), MatrixConstant<S>(expr.get_width(), expr.get_height(), val)};                            \
+    }                                                                                                                  \
+                                                                                                                       \
+    template<typename S, typename E, matrix_detail::enable_if_scalar_t<S> = 0>                                         \
+    MatrixBinaryExpression<MatrixConstant<S>, E, FUNCTOR> operator OP(const S &val, const MatrixExpression<E> &expr) { \
+        return {MatrixConstant<S>(expr.get_width(), expr.get_height(), val), expr.self()};                            \
+    }
+
+CPP_UTILS_MATRIX_SCALAR_OPERATOR(+, std::plus<>)
+CPP_UTILS_MATRIX_SCALAR_OPERATOR(-, std::minus<>)
+CPP_UTILS_MATRIX_SCALAR_OPERATOR(*, std::multiplies<>)
+CPP_UTILS_MATRIX_SCALAR_OPERATOR(/, std::divides<>)
+
+#undef CPP_UTILS_MATRIX_SCALAR_OPERATOR
+
+#endif //CPP_UTILS_MATRIXEXPRESSION_H
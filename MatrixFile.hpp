@@ -0,0 +1,473 @@
+//
+// Versioned binary Matrix files: streaming save/load and mmap-backed read-only or copy-on-write matrices
+//
+// Layout: 64-byte header (magic, version, endianness marker, element type, element size, width, height,
+// data offset) followed by the row-major elements, starting at a 64-byte aligned offset.
+//
+
+#ifndef CPP_UTILS_MATRIXFILE_H
+#define CPP_UTILS_MATRIXFILE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Matrix.hpp"
+#include "MatrixAlgorithm.hpp"
+
+namespace matrix_detail {
+
+    constexpr char FILE_MAGIC[4] = {'C', 'P', 'M', 'X'};
+    constexpr uint32_t FILE_VERSION = 1;
+    constexpr uint32_t FILE_ENDIAN_MARKER = 0x01020304;
+    constexpr uint64_t FILE_DATA_OFFSET = 64;
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t endian_marker;
+        uint32_t element_type;
+        uint32_t element_size;
+        uint32_t reserved;
+        uint64_t width;
+        uint64_t height;
+        uint64_t data_offset;
+        uint8_t padding[16];
+    };
+    static_assert(sizeof(FileHeader) == FILE_DATA_OFFSET, "Matrix file header must be 64 bytes");
+
+    // Element type codes stored in the header, 0 is an opaque trivially copyable type checked by size only
+    template<typename T>
+    struct file_element_type : std::integral_constant<uint32_t, 0> {
+    };
+
+#define CPP_UTILS_MATRIX_FILE_TYPE(TYPE, CODE) \
+    template<>                                 \
+    struct file_element_type<TYPE> : std::integral_constant<uint32_t, CODE> {};
+
+    CPP_UTILS_MATRIX_FILE_TYPE(int8_t, 1)
+    CPP_UTILS_MATRIX_FILE_TYPE(uint8_t, 2)
+    CPP_UTILS_MATRIX_FILE_TYPE(int16_t, 3)
+    CPP_UTILS_MATRIX_FILE_TYPE(uint16_t, 4)
+    CPP_UTILS_MATRIX_FILE_TYPE(int32_t, 5)
+    CPP_UTILS_MATRIX_FILE_TYPE(uint32_t, 6)
+    CPP_UTILS_MATRIX_FILE_TYPE(int64_t, 7)
+    CPP_UTILS_MATRIX_FILE_TYPE(uint64_t, 8)
+    CPP_UTILS_MATRIX_FILE_TYPE(float, 9)
+    CPP_UTILS_MATRIX_FILE_TYPE(double, 10)
+
+#undef CPP_UTILS_MATRIX_FILE_TYPE
+
+    inline uint32_t byte_swap(const uint32_t &val) {
+        return (val >> 24) | ((val >> 8) & 0xff00u) | ((val << 8) & 0xff0000u) | (val << 24);
+    }
+
+    inline uint64_t byte_swap(const uint64_t &val) {
+        return (uint64_t(byte_swap(uint32_t(val))) << 32) | byte_swap(uint32_t(val >> 32));
+    }
+
+    template<typename T>
+    void byte_swap_elements(T *data, const size_t &count) {
+        for (size_t i = 0; i < count; ++i) {
+            auto *bytes = reinterpret_cast<unsigned char *>(data + i);
+            std::reverse(bytes, bytes + sizeof(T));
+        }
+    }
+
+    template<typename T>
+    FileHeader make_file_header(const size_t &width, const size_t &height) {
+        FileHeader header = {};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+        header.version = FILE_VERSION;
+        header.endian_marker = FILE_ENDIAN_MARKER;
+        header.element_type = file_element_type<T>::value;
+        header.element_size = sizeof(T);
+        header.width = width;
+        header.height = height;
+        header.data_offset = FILE_DATA_OFFSET;
+        return header;
+    }
+
+    // Validates the header against T, returns true when the file has the opposite endianness
+    template<typename T>
+    bool check_file_header(FileHeader &header, const std::string &path) {
+        if (std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("'" + path + "' is not a Matrix file");
+        }
+        bool swapped = false;
+        if (header.endian_marker != FILE_ENDIAN_MARKER) {
+            if (byte_swap(header.endian_marker) != FILE_ENDIAN_MARKER) {
+                throw std::runtime_error("'" + path + "' has a corrupted Matrix header");
+            }
+            swapped = true;
+            header.version = byte_swap(header.version);
+            header.element_type = byte_swap(header.element_type);
+            header.element_size = byte_swap(header.element_size);
+            header.width = byte_swap(header.width);
+            header.height = byte_swap(header.height);
+            header.data_offset = byte_swap(header.data_offset);
+        }
+        if (header.version > FILE_VERSION) {
+            throw std::runtime_error("'" + path + "' uses Matrix file version " + std::to_string(header.version) +
+                                     ", newer than supported");
+        }
+        if (header.element_type != file_element_type<T>::value || header.element_size != sizeof(T)) {
+            throw std::runtime_error("'" + path + "' holds a different Matrix element type");
+        }
+        return swapped;
+    }
+
+    // Bytes of element data the header describes, throws when they do not fit in size_t along with the data offset
+    template<typename T>
+    size_t file_data_size(const FileHeader &header, const std::string &path) {
+        const uint64_t max = SIZE_MAX;
+        if (header.data_offset > max || header.width > max || header.height > max ||
+            (header.height != 0 && header.width > max / header.height) ||
+            header.width * header.height > (max - header.data_offset) / sizeof(T)) {
+            throw std::runtime_error("'" + path + "' has a corrupted Matrix header");
+        }
+        return size_t(header.width * header.height * sizeof(T));
+    }
+
+    inline std::runtime_error file_error(const std::string &what, const std::string &path) {
+        return std::runtime_error(what + " '" + path + "': " + std::strerror(errno));
+    }
+}
+
+// Streams a matrix to disk row by row, for results produced incrementally or larger than memory
+template<typename T>
+class MatrixWriter {
+    static_assert(std::is_trivially_copyable<T>::value, "MatrixWriter requires a trivially copyable element type");
+
+public:
+    MatrixWriter(const std::string &path, const size_t &width, const size_t &height);
+    MatrixWriter(const MatrixWriter &) = delete;
+    MatrixWriter(MatrixWriter &&other) noexcept = default;
+    MatrixWriter &operator=(const MatrixWriter &) = delete;
+    MatrixWriter &operator=(MatrixWriter &&other) noexcept = default;
+    ~MatrixWriter() = default;
+
+    MatrixWriter &write_rows(const T *rows, const size_t &count);
+    MatrixWriter &write_rows(const ConstMatrixView<T> &rows);
+    void close();
+
+    size_t get_rows_written() const;
+
+private:
+    std::string path;
+    std::ofstream out;
+    size_t width = 0;
+    size_t height = 0;
+    size_t rows_written = 0;
+};
+
+// Matrix backed by a file mapping, pages are faulted in on first access
+template<typename T>
+class MappedMatrix : public MatrixExpression<MappedMatrix<T>> {
+    static_assert(std::is_trivially_copyable<T>::value, "MappedMatrix requires a trivially copyable element type");
+
+public:
+    MappedMatrix(const std::string &path, const MatrixMapMode &mode = MatrixMapMode::ReadOnly);
+    MappedMatrix(const MappedMatrix &) = delete;
+    MappedMatrix(MappedMatrix &&other) noexcept;
+    MappedMatrix &operator=(const MappedMatrix &) = delete;
+    MappedMatrix &operator=(MappedMatrix &&other) noexcept;
+    ~MappedMatrix();
+
+    const T &at(const size_t &x, const size_t &y) const;
+
+    size_t get_width() const;
+    size_t get_height() const;
+    size_t get_surface() const;
+    const T *get_data() const;
+    MatrixMapMode get_mode() const;
+    bool aliases(const matrix_detail::StorageRegion &region) const;
+
+    ConstMatrixView<T> view() const;
+    // Private writable view, only available for copy-on-write mappings
+    MatrixView<T> mutable_view();
+
+    operator ConstMatrixView<T>() const;
+
+private:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+    T *data = nullptr;
+    size_t width = 0;
+    size_t height = 0;
+    MatrixMapMode mode = MatrixMapMode::ReadOnly;
+
+    void unmap();
+};
+
+template<typename T>
+void save_matrix(const std::string &path, const ConstMatrixView<T> &mat);
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+void save_matrix(const std::string &path, const M &mat);
+
+template<typename T, typename Allocator = AlignedAllocator<T>>
+Matrix<T, Allocator> load_matrix(const std::string &path);
+
+// Functions definitions
+
+template<typename T>
+MatrixWriter<T>::MatrixWriter(const std::string &path, const size_t &width, const size_t &height)
+        : path(path), out(path, std::ios::binary | std::ios::trunc), width(width), height(height) {
+    if (!out) {
+        throw matrix_detail::file_error("Cannot open for writing", path);
+    }
+    const matrix_detail::FileHeader header = matrix_detail::make_file_header<T>(width, height);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+template<typename T>
+MatrixWriter<T> &MatrixWriter<T>::write_rows(const T *rows, const size_t &count) {
+    if (rows_written + count > height) {
+        throw std::invalid_argument("MatrixWriter<T>::write_rows(rows, count) writes past the last row");
+    }
+    out.write(reinterpret_cast<const char *>(rows), std::streamsize(count * width * sizeof(T)));
+    if (!out) {
+        throw matrix_detail::file_error("Cannot write", path);
+    }
+    rows_written += count;
+    return *this;
+}
+
+template<typename T>
+MatrixWriter<T> &MatrixWriter<T>::write_rows(const ConstMatrixView<T> &rows) {
+    if (rows.get_width() != width) {
+        throw std::invalid_argument("MatrixWriter<T>::write_rows(view) requires a view of the matrix width");
+    }
+    if (rows.is_contiguous()) {
+        return write_rows(rows.get_data(), rows.get_height());
+    }
+    if (rows.get_col_stride() == 1) {
+        for (size_t y = 0; y < rows.get_height(); ++y) {
+            write_rows(&rows.at(0, y), 1);
+        }
+        return *this;
+    }
+    std::vector<T> buffer(width);
+    for (size_t y = 0; y < rows.get_height(); ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            buffer[x] = rows.at(x, y);
+        }
+        write_rows(buffer.data(), 1);
+    }
+    return *this;
+}
+
+template<typename T>
+void MatrixWriter<T>::close() {
+    if (rows_written != height) {
+        throw std::runtime_error("MatrixWriter for '" + path + "' closed after " + std::to_string(rows_written) +
+                                 " of " + std::to_string(height) + " rows");
+    }
+    out.close();
+    if (!out) {
+        throw matrix_detail::file_error("Cannot write", path);
+    }
+}
+
+template<typename T>
+size_t MatrixWriter<T>::get_rows_written() const {
+    return rows_written;
+}
+
+template<typename T>
+MappedMatrix<T>::MappedMatrix(const std::string &path, const MatrixMapMode &mode) : mode(mode) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw matrix_detail::file_error("Cannot open", path);
+    }
+    struct stat info = {};
+    if (fstat(fd, &info) != 0) {
+        const std::runtime_error error = matrix_detail::file_error("Cannot stat", path);
+        ::close(fd);
+        throw error;
+    }
+    mapping_size = size_t(info.st_size);
+    if (mapping_size < sizeof(matrix_detail::FileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("'" + path + "' is too small to be a Matrix file");
+    }
+    const int protection = mode == MatrixMapMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    mapping = mmap(nullptr, mapping_size, protection, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw matrix_detail::file_error("Cannot map", path);
+    }
+
+    matrix_detail::FileHeader header = {};
+    std::memcpy(&header, mapping, sizeof(header));
+    try {
+        if (matrix_detail::check_file_header<T>(header, path) && sizeof(T) > 1) {
+            throw std::runtime_error("'" + path +
+                                     "' has the opposite endianness and cannot be mapped, use load_matrix");
+        }
+        const size_t bytes = matrix_detail::file_data_size<T>(header, path);
+        if (header.data_offset % alignof(T) != 0 || mapping_size < header.data_offset + bytes) {
+            throw std::runtime_error("'" + path + "' is truncated");
+        }
+    } catch (...) {
+        unmap();
+        throw;
+    }
+    width = header.width;
+    height = header.height;
+    data = reinterpret_cast<T *>(static_cast<char *>(mapping) + header.data_offset);
+    madvise(mapping, mapping_size, MADV_WILLNEED);
+}
+
+template<typename T>
+MappedMatrix<T>::MappedMatrix(MappedMatrix &&other) noexcept : mapping(other.mapping),
+                                                                mapping_size(other.mapping_size),
+                                                                data(other.data), width(other.width),
+                                                                height(other.height), mode(other.mode) {
+    other.mapping = nullptr;
+    other.data = nullptr;
+    other.width = 0;
+    other.height = 0;
+}
+
+template<typename T>
+MappedMatrix<T> &MappedMatrix<T>::operator=(MappedMatrix &&other) noexcept {
+    if (&other != this) {
+        unmap();
+        mapping = other.mapping;
+        mapping_size = other.mapping_size;
+        data = other.data;
+        width = other.width;
+        height = other.height;
+        mode = other.mode;
+        other.mapping = nullptr;
+        other.data = nullptr;
+        other.width = 0;
+        other.height = 0;
+    }
+    return *this;
+}
+
+template<typename T>
+MappedMatrix<T>::~MappedMatrix() {
+    unmap();
+}
+
+template<typename T>
+void MappedMatrix<T>::unmap() {
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_size);
+        mapping = nullptr;
+        data = nullptr;
+    }
+}
+
+template<typename T>
+const T &MappedMatrix<T>::at(const size_t &x, const size_t &y) const {
+    return data[x + y * width];
+}
+
+template<typename T>
+size_t MappedMatrix<T>::get_width() const {
+    return width;
+}
+
+template<typename T>
+size_t MappedMatrix<T>::get_height() const {
+    return height;
+}
+
+template<typename T>
+size_t MappedMatrix<T>::get_surface() const {
+    return width * height;
+}
+
+template<typename T>
+const T *MappedMatrix<T>::get_data() const {
+    return data;
+}
+
+template<typename T>
+MatrixMapMode MappedMatrix<T>::get_mode() const {
+    return mode;
+}
+
+template<typename T>
+bool MappedMatrix<T>::aliases(const matrix_detail::StorageRegion &region) const {
+    return matrix_detail::regions_conflict(region, {data, width, height, ptrdiff_t(width), 1, sizeof(T)});
+}
+
+template<typename T>
+ConstMatrixView<T> MappedMatrix<T>::view() const {
+    return ConstMatrixView<T>(data, width, height, ptrdiff_t(width));
+}
+
+template<typename T>
+MatrixView<T> MappedMatrix<T>::mutable_view() {
+    if (mode != MatrixMapMode::CopyOnWrite) {
+        throw std::invalid_argument("MappedMatrix<T>::mutable_view() requires a copy-on-write mapping");
+    }
+    return MatrixView<T>(data, width, height, ptrdiff_t(width));
+}
+
+template<typename T>
+MappedMatrix<T>::operator ConstMatrixView<T>() const {
+    return view();
+}
+
+template<typename T, typename Allocator>
+MappedMatrix<T> Matrix<T, Allocator>::map_file(const std::string &path, const MatrixMapMode &mode) {
+    return MappedMatrix<T>(path, mode);
+}
+
+template<typename T>
+void save_matrix(const std::string &path, const ConstMatrixView<T> &mat) {
+    MatrixWriter<T> writer(path, mat.get_width(), mat.get_height());
+    writer.write_rows(mat);
+    writer.close();
+}
+
+template<typename M, matrix_detail::enable_if_viewable_t<M>>
+void save_matrix(const std::string &path, const M &mat) {
+    save_matrix(path, matrix_detail::const_view(mat));
+}
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator> load_matrix(const std::string &path) {
+    static_assert(std::is_trivially_copyable<T>::value, "load_matrix requires a trivially copyable element type");
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw matrix_detail::file_error("Cannot open", path);
+    }
+    matrix_detail::FileHeader header = {};
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        throw std::runtime_error("'" + path + "' is too small to be a Matrix file");
+    }
+    const bool swapped = matrix_detail::check_file_header<T>(header, path);
+    const size_t bytes = matrix_detail::file_data_size<T>(header, path);
+    in.seekg(std::streamoff(header.data_offset));
+
+    Matrix<T, Allocator> result(header.width, header.height, Matrix<T, Allocator>::uninitialized);
+    if (!in.read(reinterpret_cast<char *>(result.get_data()), std::streamsize(bytes))) {
+        throw std::runtime_error("'" + path + "' is truncated");
+    }
+    if (swapped) {
+        matrix_detail::byte_swap_elements(result.get_data(), result.get_surface());
+    }
+    return result;
+}
+
+#endif //CPP_UTILS_MATRIXFILE_H
@@ -0,0 +1,280 @@
+//
+// Transposition and tiled storage layouts for Matrix
+//
+// Transposes recurse on the larger dimension until blocks fit in L1, which keeps both the reads and the
+// strided writes cache-resident whatever the cache sizes are. Large halves are spawned as OpenMP tasks.
+//
+
+#ifndef CPP_UTILS_MATRIXLAYOUT_H
+#define CPP_UTILS_MATRIXLAYOUT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib> // size_t
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "MatrixAlgorithm.hpp"
+
+namespace matrix_detail {
+
+    constexpr size_t TRANSPOSE_LEAF = 32 * 32;
+    constexpr size_t TRANSPOSE_TASK = 256 * 256;
+
+    // dst = src^T, dst is src.get_height() wide and src.get_width() high
+    template<typename T>
+    void transpose_recursive(const ConstMatrixView<T> &src, const MatrixView<T> &dst) {
+        const size_t width = src.get_width();
+        const size_t height = src.get_height();
+        if (width * height <= TRANSPOSE_LEAF) {
+            for (size_t y = 0; y < height; ++y) {
+                for (size_t x = 0; x < width; ++x) {
+                    dst.at(y, x) = src.at(x, y);
+                }
+            }
+            return;
+        }
+        // Views assign element-wise, so halves are bound once at construction
+        const bool wide = width >= height;
+        const size_t half = wide ? width / 2 : height / 2;
+        const ConstMatrixView<T> src0 = wide ? src.view(0, 0, half, height) : src.view(0, 0, width, half);
+        const ConstMatrixView<T> src1 = wide ? src.view(half, 0, width - half, height)
+                                             : src.view(0, half, width, height - half);
+        const MatrixView<T> dst0 = wide ? dst.view(0, 0, height, half) : dst.view(0, 0, half, width);
+        const MatrixView<T> dst1 = wide ? dst.view(0, half, height, width - half)
+                                        : dst.view(half, 0, height - half, width);
+#pragma omp task default(none) firstprivate(src0, dst0) if (width * height > TRANSPOSE_TASK)
+        transpose_recursive(src0, dst0);
+        transpose_recursive(src1, dst1);
+#pragma omp taskwait
+    }
+
+    // Swaps a(x, y) with b(y, x), a and b being disjoint transposed-shape blocks
+    template<typename T>
+    void swap_transposed(const MatrixView<T> &a, const MatrixView<T> &b) {
+        const size_t width = a.get_width();
+        const size_t height = a.get_height();
+        if (width * height <= TRANSPOSE_LEAF) {
+            for (size_t y = 0; y < height; ++y) {
+                for (size_t x = 0; x < width; ++x) {
+                    std::swap(a.at(x, y), b.at(y, x));
+                }
+            }
+            return;
+        }
+        const bool wide = width >= height;
+        const size_t half = wide ? width / 2 : height / 2;
+        const MatrixView<T> a0 = wide ? a.view(0, 0, half, height) : a.view(0, 0, width, half);
+        const MatrixView<T> a1 = wide ? a.view(half, 0, width - half, height) : a.view(0, half, width, height - half);
+        const MatrixView<T> b0 = wide ? b.view(0, 0, height, half) : b.view(0, 0, half, width);
+        const MatrixView<T> b1 = wide ? b.view(0, half, height, width - half) : b.view(half, 0, height - half, width);
+#pragma omp task default(none) firstprivate(a0, b0) if (width * height > TRANSPOSE_TASK)
+        swap_transposed(a0, b0);
+        swap_transposed(a1, b1);
+#pragma omp taskwait
+    }
+
+    template<typename T>
+    void transpose_square(const MatrixView<T> &mat) {
+        const size_t n = mat.get_width();
+        if (n * n <= TRANSPOSE_LEAF) {
+            for (size_t y = 0; y < n; ++y) {
+                for (size_t x = y + 1; x < n; ++x) {
+                    std::swap(mat.at(x, y), mat.at(y, x));
+                }
+            }
+            return;
+        }
+        const size_t half = n / 2;
+        const MatrixView<T> top_left = mat.view(0, 0, half, half);
+        const MatrixView<T> bottom_right = mat.view(half, half, n - half, n - half);
+        const MatrixView<T> top_right = mat.view(half, 0, n - half, half);
+        const MatrixView<T> bottom_left = mat.view(0, half, half, n - half);
+#pragma omp task default(none) firstprivate(top_left) if (n * n > TRANSPOSE_TASK)
+        transpose_square(top_left);
+#pragma omp task default(none) firstprivate(bottom_right) if (n * n > TRANSPOSE_TASK)
+        transpose_square(bottom_right);
+        swap_transposed(top_right, bottom_left);
+#pragma omp taskwait
+    }
+
+    // Spreads the low 16 bits of v to the even bit positions
+    inline uint32_t spread_bits(uint32_t v) {
+        v &= 0x0000ffffu;
+        v = (v | (v << 8)) & 0x00ff00ffu;
+        v = (v | (v << 4)) & 0x0f0f0f0fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    }
+}
+
+// Row-major B x B tiles, tiles stored row-major
+template<size_t B = 8>
+struct BlockLayout {
+    static constexpr size_t TILE = B;
+
+    static size_t index(const size_t &x, const size_t &y, const size_t &padded_width) {
+        const size_t tile = (y / B) * (padded_width / B) + x / B;
+        return (tile * B + y % B) * B + x % B;
+    }
+};
+
+// Z-order (Morton) curve inside S x S tiles, tiles stored row-major, S a power of two up to 2^16
+template<size_t S = 64>
+struct MortonLayout {
+    static_assert(S > 0 && (S & (S - 1)) == 0 && S <= 65536, "MortonLayout requires a power of two tile size");
+    static constexpr size_t TILE = S;
+
+    static size_t index(const size_t &x, const size_t &y, const size_t &padded_width) {
+        const size_t tile = (y / S) * (padded_width / S) + x / S;
+        const size_t local = matrix_detail::spread_bits(uint32_t(x % S)) |
+                             (matrix_detail::spread_bits(uint32_t(y % S)) << 1);
+        return tile * S * S + local;
+    }
+};
+
+// Matrix copy stored along a tiled layout, for 2D-neighborhood kernels. Dimensions are padded to whole tiles.
+template<typename T, typename Layout = BlockLayout<>>
+class TiledMatrix : public MatrixExpression<TiledMatrix<T, Layout>> {
+public:
+    TiledMatrix() = default;
+    TiledMatrix(const size_t &width, const size_t &height);
+    explicit TiledMatrix(const ConstMatrixView<T> &src);
+    template<typename Allocator>
+    explicit TiledMatrix(const Matrix<T, Allocator> &src);
+
+    const T &at(const size_t &x, const size_t &y) const;
+    T &at(const size_t &x, const size_t &y);
+
+    size_t get_width() const;
+    size_t get_height() const;
+    size_t get_padded_width() const;
+    size_t get_padded_height() const;
+
+    T *get_data();
+    const T *get_data() const;
+
+    bool aliases(const matrix_detail::StorageRegion &region) const;
+
+    Matrix<T> to_matrix() const;
+
+private:
+    size_t width = 0;
+    size_t height = 0;
+    size_t padded_width = 0;
+    size_t padded_height = 0;
+    std::vector<T, AlignedAllocator<T>> data = {};
+};
+
+template<typename M, matrix_detail::enable_if_viewable_t<M> = 0>
+Matrix<matrix_detail::view_value_t<M>> transpose(const M &src);
+
+template<typename T, typename Allocator>
+void transpose_in_place(Matrix<T, Allocator> &mat);
+
+// Functions definitions
+
+template<typename M, matrix_detail::enable_if_viewable_t<M>>
+Matrix<matrix_detail::view_value_t<M>> transpose(const M &src) {
+    using T = matrix_detail::view_value_t<M>;
+    const ConstMatrixView<T> in = matrix_detail::const_view(src);
+    Matrix<T> result = matrix_detail::make_output<T>(in.get_height(), in.get_width());
+    const MatrixView<T> out = result.view();
+#pragma omp parallel default(none) shared(in, out)
+#pragma omp single
+    matrix_detail::transpose_recursive(in, out);
+    return result;
+}
+
+template<typename T, typename Allocator>
+void transpose_in_place(Matrix<T, Allocator> &mat) {
+    if (mat.get_width() != mat.get_height()) {
+        throw std::invalid_argument("transpose_in_place(mat) requires a square matrix");
+    }
+    const MatrixView<T> view = mat.view();
+#pragma omp parallel default(none) shared(view)
+#pragma omp single
+    matrix_detail::transpose_square(view);
+}
+
+template<typename T, typename Layout>
+TiledMatrix<T, Layout>::TiledMatrix(const size_t &width, const size_t &height)
+        : width(width), height(height),
+          padded_width((width + Layout::TILE - 1) / Layout::TILE * Layout::TILE),
+          padded_height((height + Layout::TILE - 1) / Layout::TILE * Layout::TILE),
+          data(padded_width * padded_height) {}
+
+template<typename T, typename Layout>
+TiledMatrix<T, Layout>::TiledMatrix(const ConstMatrixView<T> &src) : TiledMatrix(src.get_width(), src.get_height()) {
+    const size_t tile_rows = padded_height / Layout::TILE;
+#pragma omp parallel for default(none) shared(src, tile_rows)
+    for (size_t ty = 0; ty < tile_rows; ++ty) {
+        const size_t y_end = std::min(height, (ty + 1) * Layout::TILE);
+        for (size_t y = ty * Layout::TILE; y < y_end; ++y) {
+            for (size_t x = 0; x < width; ++x) {
+                data[Layout::index(x, y, padded_width)] = src.at(x, y);
+            }
+        }
+    }
+}
+
+template<typename T, typename Layout>
+template<typename Allocator>
+TiledMatrix<T, Layout>::TiledMatrix(const Matrix<T, Allocator> &src) : TiledMatrix(src.view()) {}
+
+template<typename T, typename Layout>
+const T &TiledMatrix<T, Layout>::at(const size_t &x, const size_t &y) const {
+    return data[Layout::index(x, y, padded_width)];
+}
+
+template<typename T, typename Layout>
+T &TiledMatrix<T, Layout>::at(const size_t &x, const size_t &y) {
+    return data[Layout::index(x, y, padded_width)];
+}
+
+template<typename T, typename Layout>
+size_t TiledMatrix<T, Layout>::get_width() const {
+    return width;
+}
+
+template<typename T, typename Layout>
+size_t TiledMatrix<T, Layout>::get_height() const {
+    return height;
+}
+
+template<typename T, typename Layout>
+size_t TiledMatrix<T, Layout>::get_padded_width() const {
+    return padded_width;
+}
+
+template<typename T, typename Layout>
+size_t TiledMatrix<T, Layout>::get_padded_height() const {
+    return padded_height;
+}
+
+template<typename T, typename Layout>
+T *TiledMatrix<T, Layout>::get_data() {
+    return data.data();
+}
+
+template<typename T, typename Layout>
+const T *TiledMatrix<T, Layout>::get_data() const {
+    return data.data();
+}
+
+// Tiles do not map to strides, so any overlap with the padded storage counts
+template<typename T, typename Layout>
+bool TiledMatrix<T, Layout>::aliases(const matrix_detail::StorageRegion &region) const {
+    return matrix_detail::regions_conflict(region, {data.data(), data.size(), 1, 0, 1, sizeof(T)});
+}
+
+template<typename T, typename Layout>
+Matrix<T> TiledMatrix<T, Layout>::to_matrix() const {
+    return Matrix<T>(*this);
+}
+
+#endif //CPP_UTILS_MATRIXLAYOUT_H
@@ -0,0 +1,309 @@
+//
+// Matrix product, cache-blocked with packed panels and a register-tiled microkernel
+//
+
+#ifndef CPP_UTILS_MATRIXMULTIPLY_H
+#define CPP_UTILS_MATRIXMULTIPLY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "Matrix.hpp"
+
+#if defined(__AVX2__) && defined(__FMA__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator> multiply(const Matrix<T, Allocator> &lhs, const Matrix<T, Allocator> &rhs);
+
+template<typename L, typename R>
+Matrix<std::remove_const_t<L>> multiply(const BasicMatrixView<L> &lhs, const BasicMatrixView<R> &rhs);
+
+namespace matrix_detail {
+
+    // Strided read-only access to a row-major or transposed operand
+    template<typename T>
+    struct GemmOperand {
+        const T *data;
+        ptrdiff_t row_stride;
+        ptrdiff_t col_stride;
+
+        const T &operator()(const size_t &row, const size_t &col) const {
+            return data[ptrdiff_t(row) * row_stride + ptrdiff_t(col) * col_stride];
+        }
+    };
+
+    // Portable microkernel: c[MR x NR] += a[kc x MR] * b[kc x NR], panels packed
+    template<typename T>
+    struct GemmKernel {
+        static constexpr size_t MR = 4;
+        static constexpr size_t NR = 4;
+        static constexpr size_t MC = 64;
+        static constexpr size_t KC = 256;
+        static constexpr size_t NC = 2048;
+
+        static void run(const size_t &kc, const T *a, const T *b, T *c, const size_t &ldc) {
+            T acc[MR][NR] = {};
+            for (size_t p = 0; p < kc; ++p) {
+                for (size_t i = 0; i < MR; ++i) {
+                    for (size_t j = 0; j < NR; ++j) {
+                        acc[i][j] += a[p * MR + i] * b[p * NR + j];
+                    }
+                }
+            }
+            for (size_t i = 0; i < MR; ++i) {
+                for (size_t j = 0; j < NR; ++j) {
+                    c[i * ldc + j] += acc[i][j];
+                }
+            }
+        }
+    };
+
+#if defined(__AVX2__) && defined(__FMA__) || defined(__AVX512F__)
+
+    // SIMD register abstraction used by the vectorized microkernel
+    template<typename T, size_t Bits>
+    struct SimdRegister;
+
+#if defined(__AVX2__) && defined(__FMA__)
+    template<>
+    struct SimdRegister<float, 256> {
+        using type = __m256;
+        static constexpr size_t width = 8;
+        static type zero() { return _mm256_setzero_ps(); }
+        static type load(const float *p) { return _mm256_loadu_ps(p); }
+        static type broadcast(const float *p) { return _mm256_broadcast_ss(p); }
+        static type fma(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+        static type add(type a, type b) { return _mm256_add_ps(a, b); }
+        static void store(float *p, type v) { _mm256_storeu_ps(p, v); }
+    };
+
+    template<>
+    struct SimdRegister<double, 256> {
+        using type = __m256d;
+        static constexpr size_t width = 4;
+        static type zero() { return _mm256_setzero_pd(); }
+        static type load(const double *p) { return _mm256_loadu_pd(p); }
+        static type broadcast(const double *p) { return _mm256_broadcast_sd(p); }
+        static type fma(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c); }
+        static type add(type a, type b) { return _mm256_add_pd(a, b); }
+        static void store(double *p, type v) { _mm256_storeu_pd(p, v); }
+    };
+#endif
+
+#if defined(__AVX512F__)
+    template<>
+    struct SimdRegister<float, 512> {
+        using type = __m512;
+        static constexpr size_t width = 16;
+        static type zero() { return _mm512_setzero_ps(); }
+        static type load(const float *p) { return _mm512_loadu_ps(p); }
+        static type broadcast(const float *p) { return _mm512_set1_ps(*p); }
+        static type fma(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+        static type add(type a, type b) { return _mm512_add_ps(a, b); }
+        static void store(float *p, type v) { _mm512_storeu_ps(p, v); }
+    };
+
+    template<>
+    struct SimdRegister<double, 512> {
+        using type = __m512d;
+        static constexpr size_t width = 8;
+        static type zero() { return _mm512_setzero_pd(); }
+        static type load(const double *p) { return _mm512_loadu_pd(p); }
+        static type broadcast(const double *p) { return _mm512_set1_pd(*p); }
+        static type fma(type a, type b, type c) { return _mm512_fmadd_pd(a, b, c); }
+        static type add(type a, type b) { return _mm512_add_pd(a, b); }
+        static void store(double *p, type v) { _mm512_storeu_pd(p, v); }
+    };
+
+    constexpr size_t GEMM_SIMD_BITS = 512;
+    constexpr size_t GEMM_SIMD_ROWS = 12;
+#else
+    constexpr size_t GEMM_SIMD_BITS = 256;
+    constexpr size_t GEMM_SIMD_ROWS = 6;
+#endif
+
+    // MR rows times two SIMD registers of columns held in registers for the whole kc loop
+    template<typename T>
+    struct SimdGemmKernel {
+        using Reg = SimdRegister<T, GEMM_SIMD_BITS>;
+        using reg_t = typename Reg::type;
+
+        static constexpr size_t MR = GEMM_SIMD_ROWS;
+        static constexpr size_t NR = 2 * Reg::width;
+        static constexpr size_t MC = MR * 16;
+        static constexpr size_t KC = 256;
+        static constexpr size_t NC = NR * 256;
+
+        static void run(const size_t &kc, const T *a, const T *b, T *c, const size_t &ldc) {
+            reg_t acc0[MR];
+            reg_t acc1[MR];
+#pragma GCC unroll 16
+            for (size_t i = 0; i < MR; ++i) {
+                acc0[i] = Reg::zero();
+                acc1[i] = Reg::zero();
+            }
+            for (size_t p = 0; p < kc; ++p) {
+                const reg_t b0 = Reg::load(b);
+                const reg_t b1 = Reg::load(b + Reg::width);
+#pragma GCC unroll 16
+                for (size_t i = 0; i < MR; ++i) {
+                    const reg_t ai = Reg::broadcast(a + i);
+                    acc0[i] = Reg::fma(ai, b0, acc0[i]);
+                    acc1[i] = Reg::fma(ai, b1, acc1[i]);
+                }
+                a += MR;
+                b += NR;
+            }
+#pragma GCC unroll 16
+            for (size_t i = 0; i < MR; ++i) {
+                T *row = c + i * ldc;
+                Reg::store(row, Reg::add(acc0[i], Reg::load(row)));
+                Reg::store(row + Reg::width, Reg::add(acc1[i], Reg::load(row + Reg::width)));
+            }
+        }
+    };
+
+    template<>
+    struct GemmKernel<float> : SimdGemmKernel<float> {
+    };
+
+    template<>
+    struct GemmKernel<double> : SimdGemmKernel<double> {
+    };
+
+#endif
+
+    // Packs rows [row0, row0 + mc) x depth [p0, p0 + kc) of A into MR-row slivers, zero-padded
+    template<typename T, typename Kernel>
+    void pack_lhs(const GemmOperand<T> &lhs, const size_t &row0, const size_t &mc,
+                  const size_t &p0, const size_t &kc, T *packed) {
+        for (size_t ir = 0; ir < mc; ir += Kernel::MR) {
+            const size_t mr = std::min(Kernel::MR, mc - ir);
+            for (size_t p = 0; p < kc; ++p) {
+                size_t i = 0;
+                for (; i < mr; ++i) {
+                    packed[i] = lhs(row0 + ir + i, p0 + p);
+                }
+                for (; i < Kernel::MR; ++i) {
+                    packed[i] = T();
+                }
+                packed += Kernel::MR;
+            }
+        }
+    }
+
+    // Packs the NR-column sliver starting at col0 of depth [p0, p0 + kc) of B, zero-padded
+    template<typename T, typename Kernel>
+    void pack_rhs_sliver(const GemmOperand<T> &rhs, const size_t &col0, const size_t &nr,
+                         const size_t &p0, const size_t &kc, T *packed) {
+        for (size_t p = 0; p < kc; ++p) {
+            size_t j = 0;
+            for (; j < nr; ++j) {
+                packed[j] = rhs(p0 + p, col0 + j);
+            }
+            for (; j < Kernel::NR; ++j) {
+                packed[j] = T();
+            }
+            packed += Kernel::NR;
+        }
+    }
+
+    // C[m x n] += A[m x k] * B[k x n], C row-major with leading dimension ldc
+    template<typename T>
+    void gemm(const size_t &m, const size_t &n, const size_t &k,
+              const GemmOperand<T> &lhs, const GemmOperand<T> &rhs, T *out, const size_t &ldc) {
+        using Kernel = GemmKernel<T>;
+
+        if (m == 0 || n == 0 || k == 0) {
+            return;
+        }
+
+        const size_t padded_n = (n + Kernel::NR - 1) / Kernel::NR * Kernel::NR;
+        std::vector<T> packed_rhs(Kernel::KC * std::min(Kernel::NC, padded_n));
+
+#pragma omp parallel default(none) shared(m, n, k, lhs, rhs, out, ldc, packed_rhs)
+        {
+            std::vector<T> packed_lhs(Kernel::MC * Kernel::KC);
+            T edge[Kernel::MR * Kernel::NR];
+
+            for (size_t jc = 0; jc < n; jc += Kernel::NC) {
+                const size_t nc = std::min(Kernel::NC, n - jc);
+                const size_t slivers = (nc + Kernel::NR - 1) / Kernel::NR;
+                for (size_t pc = 0; pc < k; pc += Kernel::KC) {
+                    const size_t kc = std::min(Kernel::KC, k - pc);
+
+#pragma omp for schedule(static)
+                    for (size_t s = 0; s < slivers; ++s) {
+                        const size_t col = s * Kernel::NR;
+                        pack_rhs_sliver<T, Kernel>(rhs, jc + col, std::min(Kernel::NR, nc - col), pc, kc,
+                                                   packed_rhs.data() + col * kc);
+                    }
+
+#pragma omp for schedule(dynamic)
+                    for (size_t ic = 0; ic < m; ic += Kernel::MC) {
+                        const size_t mc = std::min(Kernel::MC, m - ic);
+                        pack_lhs<T, Kernel>(lhs, ic, mc, pc, kc, packed_lhs.data());
+                        for (size_t jr = 0; jr < nc; jr += Kernel::NR) {
+                            const size_t nr = std::min(Kernel::NR, nc - jr);
+                            const T *b = packed_rhs.data() + (jr / Kernel::NR) * Kernel::NR * kc;
+                            for (size_t ir = 0; ir < mc; ir += Kernel::MR) {
+                                const size_t mr = std::min(Kernel::MR, mc - ir);
+                                const T *a = packed_lhs.data() + (ir / Kernel::MR) * Kernel::MR * kc;
+                                T *c = out + (ic + ir) * ldc + jc + jr;
+                                if (mr == Kernel::MR && nr == Kernel::NR) {
+                                    Kernel::run(kc, a, b, c, ldc);
+                                } else {
+                                    std::fill(edge, edge + Kernel::MR * Kernel::NR, T());
+                                    Kernel::run(kc, a, b, edge, Kernel::NR);
+                                    for (size_t i = 0; i < mr; ++i) {
+                                        for (size_t j = 0; j < nr; ++j) {
+                                            c[i * ldc + j] += edge[i * Kernel::NR + j];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Functions definitions
+
+template<typename T, typename Allocator>
+Matrix<T, Allocator> multiply(const Matrix<T, Allocator> &lhs, const Matrix<T, Allocator> &rhs) {
+    if (lhs.get_width() != rhs.get_height()) {
+        throw std::invalid_argument("Matrix<T> multiply(lhs, rhs) requires lhs.get_width() == rhs.get_height()");
+    }
+    Matrix<T, Allocator> result(rhs.get_width(), lhs.get_height(), T(), lhs.get_allocator());
+    matrix_detail::gemm<T>(lhs.get_height(), rhs.get_width(), lhs.get_width(),
+                           {lhs.get_data(), ptrdiff_t(lhs.get_width()), 1},
+                           {rhs.get_data(), ptrdiff_t(rhs.get_width()), 1},
+                           result.get_data(), result.get_width());
+    return result;
+}
+
+// Views of any stride are packed directly, transposed operands cost nothing extra
+template<typename L, typename R>
+Matrix<std::remove_const_t<L>> multiply(const BasicMatrixView<L> &lhs, const BasicMatrixView<R> &rhs) {
+    using T = std::remove_const_t<L>;
+    static_assert(std::is_same<T, std::remove_const_t<R>>::value, "multiply(lhs, rhs) requires the same element type");
+    if (lhs.get_width() != rhs.get_height()) {
+        throw std::invalid_argument("Matrix<T> multiply(lhs, rhs) requires lhs.get_width() == rhs.get_height()");
+    }
+    Matrix<T> result(rhs.get_width(), lhs.get_height(), T());
+    matrix_detail::gemm<T>(lhs.get_height(), rhs.get_width(), lhs.get_width(),
+                           {lhs.get_data(), lhs.get_row_stride(), lhs.get_col_stride()},
+                           {rhs.get_data(), rhs.get_row_stride(), rhs.get_col_stride()},
+                           result.get_data(), result.get_width());
+    return result;
+}
+
+#endif //CPP_UTILS_MATRIXMULTIPLY_H
@@ -0,0 +1,319 @@
+//
+// Stencil engine over Matrix: 2D correlation, separable filters and rectangular morphology
+//
+// Borders are resolved up front, into a padded row buffer for horizontal passes and into a row index table for
+// vertical ones, so that the per-pixel loops carry no bounds checks and vectorize. Rows are split across threads.
+// Kernels are applied as correlation (not flipped) with the anchor at (width / 2, height / 2).
+//
+
+#ifndef CPP_UTILS_MATRIXSTENCIL_H
+#define CPP_UTILS_MATRIXSTENCIL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib> // size_t
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "MatrixAlgorithm.hpp"
+
+enum class Border {
+    Clamp,  // aaa|abcd|ddd
+    Wrap,   // bcd|abcd|abc
+    Zero,   // 000|abcd|000
+    Mirror  // dcb|abcd|cba
+};
+
+namespace matrix_detail {
+
+    // Source index for a possibly out-of-range coordinate, -1 standing for a zero sample
+    inline ptrdiff_t border_index(ptrdiff_t i, const size_t &n, const Border &border) {
+        const ptrdiff_t size = ptrdiff_t(n);
+        if (i >= 0 && i < size) {
+            return i;
+        }
+        if (size == 0) {
+            return -1;
+        }
+        switch (border) {
+            case Border::Clamp:
+                return i < 0 ? 0 : size - 1;
+            case Border::Wrap:
+                return (i % size + size) % size;
+            case Border::Mirror: {
+                if (size == 1) {
+                    return 0;
+                }
+                const ptrdiff_t period = 2 * size - 2;
+                i = (i % period + period) % period;
+                return i < size ? i : period - i;
+            }
+            case Border::Zero:
+            default:
+                return -1;
+        }
+    }
+
+    template<typename T>
+    struct CorrelateOp {
+        static T init() {
+            return T();
+        }
+
+        static T apply(const T &acc, const T &tap, const T &val) {
+            return acc + tap * val;
+        }
+    };
+
+    template<typename T>
+    struct MinOp {
+        static_assert(std::is_arithmetic<T>::value, "erode(src, width, height) requires an arithmetic element type");
+
+        static T init() {
+            return std::numeric_limits<T>::max();
+        }
+
+        static T apply(const T &acc, const T &, const T &val) {
+            return val < acc ? val : acc;
+        }
+    };
+
+    template<typename T>
+    struct MaxOp {
+        static_assert(std::is_arithmetic<T>::value, "dilate(src, width, height) requires an arithmetic element type");
+
+        static T init() {
+            return std::numeric_limits<T>::lowest();
+        }
+
+        static T apply(const T &acc, const T &, const T &val) {
+            return acc < val ? val : acc;
+        }
+    };
+
+    // Copies row y of src into buf with anchor samples of border on the left and taps - anchor - 1 on the right
+    template<typename T>
+    void pad_row(const ConstMatrixView<T> &src, const size_t &y, const size_t &taps, const size_t &anchor,
+                 const Border &border, T *buf) {
+        const size_t width = src.get_width();
+        for (size_t x = 0; x < width; ++x) {
+            buf[anchor + x] = src.at(x, y);
+        }
+        for (size_t i = 0; i < anchor; ++i) {
+            const ptrdiff_t from = border_index(ptrdiff_t(i) - ptrdiff_t(anchor), width, border);
+            buf[i] = from < 0 ? T() : src.at(size_t(from), y);
+        }
+        for (size_t i = anchor + width; i < width + taps - 1; ++i) {
+            const ptrdiff_t from = border_index(ptrdiff_t(i) - ptrdiff_t(anchor), width, border);
+            buf[i] = from < 0 ? T() : src.at(size_t(from), y);
+        }
+    }
+
+    // Sum over taps of one padded row into out, tap-major so the inner loop is contiguous and branch-free
+    template<typename T, typename Op>
+    void accumulate_row(const T *padded, const T *taps, const size_t &count, const size_t &width, T *out) {
+        for (size_t i = 0; i < count; ++i) {
+            const T tap = taps[i];
+            const T *in = padded + i;
+            for (size_t x = 0; x < width; ++x) {
+                out[x] = Op::apply(out[x], tap, in[x]);
+            }
+        }
+    }
+
+    template<typename T, typename Op>
+    void horizontal_pass(const ConstMatrixView<T> &src, Matrix<T> &dst, const std::vector<T> &taps,
+                         const Border &border) {
+        const size_t width = src.get_width();
+        const size_t height = src.get_height();
+        const size_t anchor = taps.size() / 2;
+#pragma omp parallel default(none) shared(src, dst, taps, border, width, height, anchor)
+        {
+            std::vector<T> padded(width + taps.size() - 1);
+#pragma omp for schedule(static)
+            for (size_t y = 0; y < height; ++y) {
+                pad_row(src, y, taps.size(), anchor, border, padded.data());
+                T *out = &dst.at(0, y);
+                std::fill(out, out + width, Op::init());
+                accumulate_row<T, Op>(padded.data(), taps.data(), taps.size(), width, out);
+            }
+        }
+    }
+
+    template<typename T, typename Op>
+    void vertical_pass(const ConstMatrixView<T> &src, Matrix<T> &dst, const std::vector<T> &taps,
+                       const Border &border) {
+        const size_t width = src.get_width();
+        const size_t height = src.get_height();
+        const size_t anchor = taps.size() / 2;
+        const std::vector<T> zeros(width, T());
+        const bool contiguous = src.get_col_stride() == 1;
+#pragma omp parallel default(none) shared(src, dst, taps, border, width, height, anchor, zeros, contiguous)
+        {
+            std::vector<T> gathered(contiguous ? 0 : width);
+#pragma omp for schedule(static)
+            for (size_t y = 0; y < height; ++y) {
+                T *out = &dst.at(0, y);
+                std::fill(out, out + width, Op::init());
+                for (size_t i = 0; i < taps.size(); ++i) {
+                    const ptrdiff_t from = border_index(ptrdiff_t(y + i) - ptrdiff_t(anchor), height, border);
+                    const T *in = zeros.data();
+                    if (from >= 0 && contiguous) {
+                        in = &src.at(0, size_t(from));
+                    } else if (from >= 0) {
+                        for (size_t x = 0; x < width; ++x) {
+                            gathered[x] = src.at(x, size_t(from));
+                        }
+                        in = gathered.data();
+                    }
+                    const T tap = taps[i];
+                    for (size_t x = 0; x < width; ++x) {
+                        out[x] = Op::apply(out[x], tap, in[x]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Splits a rank-1 kernel into its column and row factors, kernel(x, y) == col[y] * row[x]
+    template<typename T>
+    bool separate_kernel(const ConstMatrixView<T> &kernel, std::vector<T> &row, std::vector<T> &col) {
+        // Integer kernels are always applied directly, factoring them would round
+        if constexpr (!std::is_floating_point<T>::value) {
+            return false;
+        }
+        size_t px = 0;
+        size_t py = 0;
+        T peak = T();
+        for (size_t y = 0; y < kernel.get_height(); ++y) {
+            for (size_t x = 0; x < kernel.get_width(); ++x) {
+                if (std::abs(double(kernel.at(x, y))) > std::abs(double(peak))) {
+                    peak = kernel.at(x, y);
+                    px = x;
+                    py = y;
+                }
+            }
+        }
+        if (peak == T()) {
+            return false;
+        }
+        row.resize(kernel.get_width());
+        col.resize(kernel.get_height());
+        for (size_t x = 0; x < kernel.get_width(); ++x) {
+            row[x] = kernel.at(x, py) / peak;
+        }
+        for (size_t y = 0; y < kernel.get_height(); ++y) {
+            col[y] = kernel.at(px, y);
+        }
+        const double tolerance = std::abs(double(peak)) * double(std::numeric_limits<T>::epsilon()) * 64.0;
+        for (size_t y = 0; y < kernel.get_height(); ++y) {
+            for (size_t x = 0; x < kernel.get_width(); ++x) {
+                if (std::abs(double(kernel.at(x, y) - col[y] * row[x])) > tolerance) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+// Applies row_taps horizontally then col_taps vertically
+template<typename M>
+Matrix<matrix_detail::view_value_t<M>> convolve_separable(const M &src,
+                                                          const std::vector<matrix_detail::view_value_t<M>> &row_taps,
+                                                          const std::vector<matrix_detail::view_value_t<M>> &col_taps,
+                                                          const Border &border = Border::Clamp) {
+    using T = matrix_detail::view_value_t<M>;
+    if (row_taps.empty() || col_taps.empty()) {
+        throw std::invalid_argument("convolve_separable(src, row_taps, col_taps) requires non-empty kernels");
+    }
+    const ConstMatrixView<T> in = matrix_detail::const_view(src);
+    Matrix<T> tmp = matrix_detail::make_output<T>(in.get_width(), in.get_height());
+    Matrix<T> result = matrix_detail::make_output<T>(in.get_width(), in.get_height());
+    matrix_detail::horizontal_pass<T, matrix_detail::CorrelateOp<T>>(in, tmp, row_taps, border);
+    matrix_detail::vertical_pass<T, matrix_detail::CorrelateOp<T>>(tmp.view(), result, col_taps, border);
+    return result;
+}
+
+// 2D correlation, rank-1 floating point kernels are detected and run as two 1D passes
+template<typename M, typename K>
+Matrix<matrix_detail::view_value_t<M>> convolve(const M &src, const K &kernel, const Border &border = Border::Clamp) {
+    using T = matrix_detail::view_value_t<M>;
+    const ConstMatrixView<T> in = matrix_detail::const_view(src);
+    const ConstMatrixView<T> taps = matrix_detail::const_view(kernel);
+    if (taps.get_surface() == 0) {
+        throw std::invalid_argument("convolve(src, kernel) requires a non-empty kernel");
+    }
+    std::vector<T> row;
+    std::vector<T> col;
+    if (matrix_detail::separate_kernel(taps, row, col)) {
+        return convolve_separable(in, row, col, border);
+    }
+
+    // Pad the whole source once, after which every output row is an interior row
+    const size_t width = in.get_width();
+    const size_t height = in.get_height();
+    const size_t kw = taps.get_width();
+    const size_t kh = taps.get_height();
+    const size_t ax = kw / 2;
+    const size_t ay = kh / 2;
+    Matrix<T> padded(width + kw - 1, height + kh - 1);
+    const Matrix<T> kernel_rows(taps);
+#pragma omp parallel for default(none) shared(in, padded, border, height, kh, kw, ax, ay)
+    for (size_t py = 0; py < height + kh - 1; ++py) {
+        const ptrdiff_t from = matrix_detail::border_index(ptrdiff_t(py) - ptrdiff_t(ay), height, border);
+        if (from >= 0) {
+            matrix_detail::pad_row(in, size_t(from), kw, ax, border, &padded.at(0, py));
+        }
+    }
+
+    Matrix<T> result = matrix_detail::make_output<T>(width, height);
+#pragma omp parallel for default(none) shared(padded, kernel_rows, result, width, height, kh, kw)
+    for (size_t y = 0; y < height; ++y) {
+        T *out = &result.at(0, y);
+        std::fill(out, out + width, T());
+        for (size_t j = 0; j < kh; ++j) {
+            matrix_detail::accumulate_row<T, matrix_detail::CorrelateOp<T>>(&padded.at(0, y + j),
+                                                                            &kernel_rows.at(0, j), kw, width, out);
+        }
+    }
+    return result;
+}
+
+// Minimum over a width x height rectangle centered on each element
+template<typename M>
+Matrix<matrix_detail::view_value_t<M>> erode(const M &src, const size_t &width, const size_t &height,
+                                             const Border &border = Border::Clamp) {
+    using T = matrix_detail::view_value_t<M>;
+    if (width == 0 || height == 0) {
+        throw std::invalid_argument("erode(src, width, height) requires a non-empty structuring element");
+    }
+    const ConstMatrixView<T> in = matrix_detail::const_view(src);
+    Matrix<T> tmp = matrix_detail::make_output<T>(in.get_width(), in.get_height());
+    Matrix<T> result = matrix_detail::make_output<T>(in.get_width(), in.get_height());
+    matrix_detail::horizontal_pass<T, matrix_detail::MinOp<T>>(in, tmp, std::vector<T>(width), border);
+    matrix_detail::vertical_pass<T, matrix_detail::MinOp<T>>(tmp.view(), result, std::vector<T>(height), border);
+    return result;
+}
+
+// Maximum over a width x height rectangle centered on each element
+template<typename M>
+Matrix<matrix_detail::view_value_t<M>> dilate(const M &src, const size_t &width, const size_t &height,
+                                              const Border &border = Border::Clamp) {
+    using T = matrix_detail::view_value_t<M>;
+    if (width == 0 || height == 0) {
+        throw std::invalid_argument("dilate(src, width, height) requires a non-empty structuring element");
+    }
+    const ConstMatrixView<T> in = matrix_detail::const_view(src);
+    Matrix<T> tmp = matrix_detail::make_output<T>(in.get_width(), in.get_height());
+    Matrix<T> result = matrix_detail::make_output<T>(in.get_width(), in.get_height());
+    matrix_detail::horizontal_pass<T, matrix_detail::MaxOp<T>>(in, tmp, std::vector<T>(width), border);
+    matrix_detail::vertical_pass<T, matrix_detail::MaxOp<T>>(tmp.view(), result, std::vector<T>(height), border);
+    return result;
+}
+
+#endif //CPP_UTILS_MATRIXSTENCIL_H
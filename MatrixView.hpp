@@ -0,0 +1,348 @@
+//
+// Non-owning strided views over row-major storage: sub-matrices, rows, columns and transposes
+//
+
+#ifndef CPP_UTILS_MATRIXVIEW_H
+#define CPP_UTILS_MATRIXVIEW_H
+
+#include <cstddef>
+#include <cstdlib> // size_t
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include "MatrixExpression.hpp"
+
+template<typename E>
+class BasicMatrixView;
+
+// Writable view, assigning to it writes through to the viewed elements
+template<typename T>
+using MatrixView = BasicMatrixView<T>;
+
+template<typename T>
+using ConstMatrixView = BasicMatrixView<const T>;
+
+namespace matrix_detail {
+
+    struct not_assignable;
+
+    // Source type of the element-copying assignment of BasicMatrixView<E>, const views have none
+    template<typename E>
+    using view_assign_source_t = std::conditional_t<std::is_const<E>::value, not_assignable, BasicMatrixView<E>>;
+
+    // Row-parallel evaluation of an expression into strided storage, contiguous rows get a vectorizable loop
+    template<typename T, typename E, typename Op>
+    void evaluate(T *data, const size_t &width, const size_t &height,
+                  const ptrdiff_t &row_stride, const ptrdiff_t &col_stride, const E &source, Op op) {
+#pragma omp parallel for default(none) shared(data, width, height, row_stride, col_stride, source, op)
+        for (size_t y = 0; y < height; ++y) {
+            T *row = data + ptrdiff_t(y) * row_stride;
+            if (col_stride == 1) {
+                for (size_t x = 0; x < width; ++x) {
+                    op(row[x], source.at(x, y));
+                }
+            } else {
+                for (size_t x = 0; x < width; ++x) {
+                    op(row[ptrdiff_t(x) * col_stride], source.at(x, y));
+                }
+            }
+        }
+    }
+
+    template<typename E>
+    struct expression_storage<BasicMatrixView<E>> {
+        using type = BasicMatrixView<E>;
+    };
+
+    template<typename T, typename E, typename Op>
+    void evaluate_safely(T *data, const size_t &width, const size_t &height,
+                         const ptrdiff_t &row_stride, const ptrdiff_t &col_stride, const E &source, Op op);
+}
+
+template<typename E>
+class BasicMatrixView : public MatrixExpression<BasicMatrixView<E>> {
+public:
+    using value_type = std::remove_const_t<E>;
+    using element_type = E;
+
+    // Row-major traversal of the viewed elements
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<E>;
+        using difference_type = ptrdiff_t;
+        using pointer = E *;
+        using reference = E &;
+
+        Iterator() = default;
+        Iterator(const BasicMatrixView<E> *view, const size_t &x, const size_t &y) : data(view->data),
+                                                                                     width(view->width),
+                                                                                     row_stride(view->row_stride),
+                                                                                     col_stride(view->col_stride),
+                                                                                     x(x), y(y) {}
+
+        Iterator &operator++() {
+            if (++x == width) {
+                x = 0;
+                ++y;
+            }
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old(*this);
+            ++(*this);
+            return old;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return x == other.x && y == other.y && data == other.data;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return !(*this == other);
+        }
+
+        E &operator*() const {
+            return data[ptrdiff_t(y) * row_stride + ptrdiff_t(x) * col_stride];
+        }
+
+        E *operator->() const {
+            return &(**this);
+        }
+
+    private:
+        E *data = nullptr;
+        size_t width = 0;
+        ptrdiff_t row_stride = 0;
+        ptrdiff_t col_stride = 0;
+        size_t x = 0;
+        size_t y = 0;
+    };
+
+    BasicMatrixView() = default;
+    BasicMatrixView(E *data, const size_t &width, const size_t &height,
+                    const ptrdiff_t &row_stride, const ptrdiff_t &col_stride = 1);
+    BasicMatrixView(const BasicMatrixView<E> &other) = default;
+    BasicMatrixView(BasicMatrixView<E> &&other) noexcept = default;
+    template<typename U, typename = std::enable_if_t<std::is_same<const U, E>::value && !std::is_same<U, E>::value>>
+    BasicMatrixView(const BasicMatrixView<U> &other);
+    ~BasicMatrixView() = default;
+
+    // Copies the elements of other, which must have the same dimensions. Const views are not copy assignable: the
+    // declared move constructor deletes the implicit copy assignment, and this one takes an unrelated type.
+    BasicMatrixView<E> &operator=(const matrix_detail::view_assign_source_t<E> &other);
+    template<typename X>
+    BasicMatrixView<E> &operator=(const MatrixExpression<X> &expr);
+    template<typename X>
+    BasicMatrixView<E> &operator+=(const MatrixExpression<X> &expr);
+    template<typename X>
+    BasicMatrixView<E> &operator-=(const MatrixExpression<X> &expr);
+    BasicMatrixView<E> &fill(const value_type &val);
+
+    E &at(const size_t &x, const size_t &y) const;
+
+    size_t get_width() const;
+    size_t get_height() const;
+    size_t get_surface() const;
+    ptrdiff_t get_row_stride() const;
+    ptrdiff_t get_col_stride() const;
+    bool is_contiguous() const;
+
+    // Pointer to the element at the origin of the view
+    E *get_data() const;
+
+    bool aliases(const matrix_detail::StorageRegion &region) const;
+
+    BasicMatrixView<E> view() const;
+    BasicMatrixView<E> view(const size_t &x0, const size_t &y0, const size_t &w, const size_t &h) const;
+    BasicMatrixView<E> row(const size_t &y) const;
+    BasicMatrixView<E> column(const size_t &x) const;
+    BasicMatrixView<E> transposed() const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    template<typename U>
+    friend class BasicMatrixView;
+
+    E *data = nullptr;
+    size_t width = 0;
+    size_t height = 0;
+    ptrdiff_t row_stride = 0;
+    ptrdiff_t col_stride = 1;
+
+    template<typename X, typename Op>
+    void evaluate(const MatrixExpression<X> &expr, Op op, const char *message);
+};
+
+// Functions definitions
+
+template<typename E>
+BasicMatrixView<E>::BasicMatrixView(E *data, const size_t &width, const size_t &height,
+                                    const ptrdiff_t &row_stride, const ptrdiff_t &col_stride) : data(data),
+                                                                                                width(width),
+                                                                                                height(height),
+                                                                                                row_stride(row_stride),
+                                                                                                col_stride(col_stride) {}
+
+template<typename E>
+template<typename U, typename>
+BasicMatrixView<E>::BasicMatrixView(const BasicMatrixView<U> &other) : data(other.data), width(other.width),
+                                                                       height(other.height),
+                                                                       row_stride(other.row_stride),
+                                                                       col_stride(other.col_stride) {}
+
+template<typename E>
+BasicMatrixView<E> &BasicMatrixView<E>::operator=(const matrix_detail::view_assign_source_t<E> &other) {
+    evaluate(other, [](value_type &dst, const value_type &val) { dst = val; },
+             "BasicMatrixView<E>::operator=(other) requires a view of the same dimensions");
+    return *this;
+}
+
+template<typename E>
+template<typename X>
+BasicMatrixView<E> &BasicMatrixView<E>::operator=(const MatrixExpression<X> &expr) {
+    evaluate(expr, [](value_type &dst, const auto &val) { dst = val; },
+             "BasicMatrixView<E>::operator=(expr) requires expr of the same dimensions");
+    return *this;
+}
+
+template<typename E>
+template<typename X>
+BasicMatrixView<E> &BasicMatrixView<E>::operator+=(const MatrixExpression<X> &expr) {
+    evaluate(expr, [](value_type &dst, const auto &val) { dst += val; },
+             "BasicMatrixView<E>::operator+=(expr) requires expr of the same dimensions");
+    return *this;
+}
+
+template<typename E>
+template<typename X>
+BasicMatrixView<E> &BasicMatrixView<E>::operator-=(const MatrixExpression<X> &expr) {
+    evaluate(expr, [](value_type &dst, const auto &val) { dst -= val; },
+             "BasicMatrixView<E>::operator-=(expr) requires expr of the same dimensions");
+    return *this;
+}
+
+template<typename E>
+BasicMatrixView<E> &BasicMatrixView<E>::fill(const value_type &val) {
+    return *this = MatrixConstant<value_type>(width, height, val);
+}
+
+template<typename E>
+template<typename X, typename Op>
+void BasicMatrixView<E>::evaluate(const MatrixExpression<X> &expr, Op op, const char *message) {
+    static_assert(!std::is_const<E>::value, "Cannot write through a ConstMatrixView");
+    if (expr.get_width() != width || expr.get_height() != height) {
+        throw std::invalid_argument(message);
+    }
+    matrix_detail::evaluate_safely(data, width, height, row_stride, col_stride, expr.self(), op);
+}
+
+template<typename E>
+E &BasicMatrixView<E>::at(const size_t &x, const size_t &y) const {
+    return data[ptrdiff_t(y) * row_stride + ptrdiff_t(x) * col_stride];
+}
+
+template<typename E>
+size_t BasicMatrixView<E>::get_width() const {
+    return width;
+}
+
+template<typename E>
+size_t BasicMatrixView<E>::get_height() const {
+    return height;
+}
+
+template<typename E>
+size_t BasicMatrixView<E>::get_surface() const {
+    return width * height;
+}
+
+template<typename E>
+ptrdiff_t BasicMatrixView<E>::get_row_stride() const {
+    return row_stride;
+}
+
+template<typename E>
+ptrdiff_t BasicMatrixView<E>::get_col_stride() const {
+    return col_stride;
+}
+
+template<typename E>
+bool BasicMatrixView<E>::is_contiguous() const {
+    return col_stride == 1 && (height <= 1 || row_stride == ptrdiff_t(width));
+}
+
+template<typename E>
+E *BasicMatrixView<E>::get_data() const {
+    return data;
+}
+
+template<typename E>
+bool BasicMatrixView<E>::aliases(const matrix_detail::StorageRegion &region) const {
+    return matrix_detail::regions_conflict(region, {data, width, height, row_stride, col_stride, sizeof(E)});
+}
+
+template<typename E>
+BasicMatrixView<E> BasicMatrixView<E>::view() const {
+    return *this;
+}
+
+template<typename E>
+BasicMatrixView<E> BasicMatrixView<E>::view(const size_t &x0, const size_t &y0,
+                                            const size_t &w, const size_t &h) const {
+    if (x0 + w > width || y0 + h > height) {
+        throw std::invalid_argument("BasicMatrixView<E>::view(x0, y0, w, h) requires the region to fit in the view");
+    }
+    return BasicMatrixView<E>(data + ptrdiff_t(y0) * row_stride + ptrdiff_t(x0) * col_stride, w, h,
+                              row_stride, col_stride);
+}
+
+template<typename E>
+BasicMatrixView<E> BasicMatrixView<E>::row(const size_t &y) const {
+    return view(0, y, width, 1);
+}
+
+template<typename E>
+BasicMatrixView<E> BasicMatrixView<E>::column(const size_t &x) const {
+    return view(x, 0, 1, height);
+}
+
+template<typename E>
+BasicMatrixView<E> BasicMatrixView<E>::transposed() const {
+    return BasicMatrixView<E>(data, height, width, col_stride, row_stride);
+}
+
+template<typename E>
+typename BasicMatrixView<E>::Iterator BasicMatrixView<E>::begin() const {
+    return Iterator(this, 0, width == 0 ? height : 0);
+}
+
+template<typename E>
+typename BasicMatrixView<E>::Iterator BasicMatrixView<E>::end() const {
+    return Iterator(this, 0, height);
+}
+
+namespace matrix_detail {
+
+    // Evaluates into a temporary first when source reads the destination at other coordinates, as a transpose of it
+    template<typename T, typename E, typename Op>
+    void evaluate_safely(T *data, const size_t &width, const size_t &height,
+                         const ptrdiff_t &row_stride, const ptrdiff_t &col_stride, const E &source, Op op) {
+        if (!aliases(source, {data, width, height, row_stride, col_stride, sizeof(T)})) {
+            evaluate(data, width, height, row_stride, col_stride, source, op);
+            return;
+        }
+        using V = expression_value_t<E>;
+        std::unique_ptr<V[]> buffer(new V[width * height]);
+        evaluate(buffer.get(), width, height, ptrdiff_t(width), 1, source, [](V &dst, const V &val) { dst = val; });
+        evaluate(data, width, height, row_stride, col_stride,
+                 BasicMatrixView<const V>(buffer.get(), width, height, ptrdiff_t(width)), op);
+    }
+}
+
+#endif //CPP_UTILS_MATRIXVIEW_H
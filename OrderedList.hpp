@@ -5,19 +5,288 @@
 #ifndef LISTSGRAPH_ORDEREDLIST_HPP
 #define LISTSGRAPH_ORDEREDLIST_HPP
 
-template<typename T>
-class OrderedList {
-private:
-    struct Cell {
+#include <algorithm>
+#include <cstdlib> // size_t
+#include <iostream>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ordered_list_detail {
+
+    enum class SetOperation {
+        UNION, INTERSECTION, DIFFERENCE, SYMMETRIC_DIFFERENCE
+    };
+
+    inline bool keepsFirst(const SetOperation &op) {
+        return op != SetOperation::INTERSECTION;
+    }
+
+    inline bool keepsSecond(const SetOperation &op) {
+        return op == SetOperation::UNION || op == SetOperation::SYMMETRIC_DIFFERENCE;
+    }
+
+    inline bool keepsCommon(const SetOperation &op) {
+        return op == SetOperation::UNION || op == SetOperation::INTERSECTION;
+    }
+
+    // Single pass over two sorted ranges, passing the elements of a op b to out in order. An element present p times
+    // in a and q times in b is output max(p, q), min(p, q), max(p - q, 0) or |p - q| times, as std::set_union and
+    // friends do.
+    template<typename It, typename Out>
+    void merge(const SetOperation &op, It a, const It &aEnd, It b, const It &bEnd, Out &&out) {
+        while (a != aEnd && b != bEnd) {
+            if (*a < *b) {
+                if (keepsFirst(op)) {
+                    out(*a);
+                }
+                ++a;
+            } else if (*b < *a) {
+                if (keepsSecond(op)) {
+                    out(*b);
+                }
+                ++b;
+            } else {
+                if (keepsCommon(op)) {
+                    out(*a);
+                }
+                ++a;
+                ++b;
+            }
+        }
+        for (; keepsFirst(op) && a != aEnd; ++a) {
+            out(*a);
+        }
+        for (; keepsSecond(op) && b != bEnd; ++b) {
+            out(*b);
+        }
+    }
+
+    constexpr size_t PARALLEL_SORT = 1 << 16;
+
+    // Sorts halves as OpenMP tasks down to PARALLEL_SORT elements, then merges them back
+    template<typename T>
+    void sortRecursive(T *first, T *last) {
+        const size_t size = size_t(last - first);
+        if (size <= PARALLEL_SORT) {
+            std::sort(first, last);
+            return;
+        }
+        T *middle = first + size / 2;
+#pragma omp task default(none) firstprivate(first, middle)
+        sortRecursive(first, middle);
+        sortRecursive(middle, last);
+#pragma omp taskwait
+        std::inplace_merge(first, middle, last);
+    }
+
+    // Copies [first, last) into a sorted vector, without repeated elements when unique
+    template<typename T, typename It>
+    std::vector<T> sortedValues(It first, It last, const bool &unique) {
+        std::vector<T> values(first, last);
+        if (values.size() <= PARALLEL_SORT) {
+            std::sort(values.begin(), values.end());
+        } else {
+            T *data = values.data();
+            const size_t size = values.size();
+#pragma omp parallel default(none) shared(data, size)
+#pragma omp single
+            sortRecursive(data, data + size);
+        }
+        if (unique) {
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+        }
+        return values;
+    }
+
+    template<typename T>
+    struct ListCell {
         T val;
-        Cell *next = nullptr;
+        ListCell *next = nullptr;
+    };
+
+    // Carves cells out of chunks of growing size, recycling freed cells first. After reserve(count), the next count
+    // allocations are consecutive.
+    template<typename Cell>
+    class CellSlab {
+    public:
+        CellSlab() = default;
+
+        CellSlab(const CellSlab &) = delete;
+
+        CellSlab &operator=(const CellSlab &) = delete;
+
+        ~CellSlab() {
+            release();
+        }
+
+        void *allocate() {
+            if (reserved == 0 && freeList != nullptr) {
+                FreeSlot *slot = freeList;
+                freeList = slot->next;
+                return slot;
+            }
+            if (reserved > 0) {
+                reserved--;
+            }
+            if (bump == end) {
+                grow(1);
+            }
+            return bump++;
+        }
+
+        void deallocate(void *cell) {
+            freeList = new(cell) FreeSlot{freeList};
+        }
+
+        void reserve(const size_t &count) {
+            if (size_t(end - bump) < count) {
+                grow(count);
+            }
+            reserved = count;
+        }
+
+        // Frees every chunk, no cell may be in use
+        void release() {
+            for (void *chunk : chunks) {
+                ::operator delete(chunk, std::align_val_t(alignof(Cell)));
+            }
+            chunks.clear();
+            bump = end = nullptr;
+            freeList = nullptr;
+            reserved = 0;
+            chunkSize = MIN_CHUNK;
+        }
+
+        void swap(CellSlab &other) noexcept {
+            std::swap(chunks, other.chunks);
+            std::swap(bump, other.bump);
+            std::swap(end, other.end);
+            std::swap(freeList, other.freeList);
+            std::swap(reserved, other.reserved);
+            std::swap(chunkSize, other.chunkSize);
+        }
+
+    private:
+        static constexpr size_t MIN_CHUNK = 4;
+        static constexpr size_t MAX_CHUNK = 4096;
+
+        struct FreeSlot {
+            FreeSlot *next;
+        };
+
+        // The rest of the current chunk is dropped, chunks double up to MAX_CHUNK cells
+        void grow(const size_t &count) {
+            const size_t size = std::max(count, chunkSize);
+            chunks.reserve(chunks.size() + 1);
+            bump = static_cast<Cell *>(::operator new(size * sizeof(Cell), std::align_val_t(alignof(Cell))));
+            chunks.push_back(bump);
+            end = bump + size;
+            chunkSize = std::min(chunkSize * 2, MAX_CHUNK);
+        }
+
+        std::vector<void *> chunks;
+        Cell *bump = nullptr;
+        Cell *end = nullptr;
+        FreeSlot *freeList = nullptr;
+        size_t reserved = 0;
+        size_t chunkSize = MIN_CHUNK;
     };
+}
+
+// Cell allocation policies of LinkedCells: one new and delete per cell, a slab owned by each list, or a slab
+// shared by the lists of a thread.
+struct HeapCells {
+    template<typename Cell>
+    class Pool {
+    public:
+        void *allocate() {
+            return ::operator new(sizeof(Cell), std::align_val_t(alignof(Cell)));
+        }
+
+        void deallocate(void *cell) {
+            ::operator delete(cell, std::align_val_t(alignof(Cell)));
+        }
+
+        void reserve(const size_t &) {}
+
+        void release() {}
+
+        void swap(Pool &) noexcept {}
+    };
+};
+
+struct ListSlab {
+    template<typename Cell>
+    using Pool = ordered_list_detail::CellSlab<Cell>;
+};
+
+// A list using SharedSlab takes the slab of the thread constructing it and keeps it alive, so cells return to the
+// slab they came from even after that thread exits, and move and swap carry the slab along with the cells. The slab
+// is not synchronized: the lists sharing it may only be modified, moved from or destroyed by one thread at a time,
+// normally the thread that constructed them, or another one once that thread is done with all of them.
+struct SharedSlab {
+    template<typename Cell>
+    class Pool {
+    public:
+        Pool() : slab(threadSlab()) {}
+
+        void *allocate() {
+            return slab->allocate();
+        }
+
+        void deallocate(void *cell) {
+            slab->deallocate(cell);
+        }
+
+        void reserve(const size_t &count) {
+            slab->reserve(count);
+        }
+
+        void release() {}
+
+        void swap(Pool &other) noexcept {
+            slab.swap(other.slab);
+        }
+
+    private:
+        static const std::shared_ptr<ordered_list_detail::CellSlab<Cell>> &threadSlab() {
+            static thread_local const auto instance = std::make_shared<ordered_list_detail::CellSlab<Cell>>();
+            return instance;
+        }
+
+        std::shared_ptr<ordered_list_detail::CellSlab<Cell>> slab;
+    };
+};
+
+// Storage layouts of OrderedList: a singly linked chain of cells, or sorted arrays of up to B elements indexed by
+// a vector, which gives O(log n) lookups and inserts shifting at most B elements
+template<typename Allocation = HeapCells>
+struct LinkedCells {
+};
+
+template<size_t B = 64>
+struct SortedBlocks {
+};
+
+template<typename T, typename Layout = LinkedCells<>>
+class OrderedList;
+
+// The pool is a private base so that stateless pools take no room in the list
+template<typename T, typename Allocation>
+class OrderedList<T, LinkedCells<Allocation>>
+        : private Allocation::template Pool<ordered_list_detail::ListCell<T>> {
+private:
+    using Cell = ordered_list_detail::ListCell<T>;
+    using Pool = typename Allocation::template Pool<Cell>;
     Cell *head = nullptr;
 public:
     class iterator {
     public:
         Cell *current;
         Cell **source;
+        OrderedList *list;
     public:
         iterator &operator++() {
             if (current != nullptr) {
@@ -30,7 +299,7 @@ public:
         void remove() {
             if (current != nullptr) {
                 (*source) = current->next;
-                delete current;
+                list->destroyCell(current);
                 current = *source;
             }
         }
@@ -48,16 +317,13 @@ public:
         }
 
         void insertBefore(const T &elem) {
-            Cell *newCell = new Cell;
-            newCell->val = elem;
-            newCell->next = current;
+            Cell *newCell = list->createCell(elem, current);
             (*source) = newCell;
             source = &(newCell->next);
         }
 
         void insertAfter(const T &elem) {
-            Cell *newCell = new Cell;
-            newCell->val = elem;
+            Cell *newCell = list->createCell(elem, nullptr);
             if (current != nullptr) {
                 newCell->next = current->next;
                 current->next = newCell;
@@ -94,6 +360,11 @@ public:
 public:
     OrderedList() = default;
 
+    // Sorts a copy of [first, last), in parallel for large ranges, and builds the list in one pass. Repeated
+    // elements are kept once when unique.
+    template<typename It>
+    OrderedList(It first, It last, const bool &unique = false);
+
     OrderedList(const OrderedList &other);
 
     OrderedList(OrderedList &&other) noexcept;
@@ -114,6 +385,10 @@ public:
 
     void addAll(const OrderedList &other);
 
+    // Replaces the content by [first, last), as the range constructor
+    template<typename It>
+    void assign(It first, It last, const bool &unique = false);
+
     bool contains(const T &elem) const;
 
     bool isEmpty() const;
@@ -132,58 +407,78 @@ public:
 
     void display() const;
 
+    // Set algebra in O(n + m) with multiset semantics: unite keeps max(p, q) copies of an element present p times
+    // here and q times in other, intersect min(p, q), subtract max(p - q, 0) and symmetricDifference |p - q|
+    OrderedList unite(const OrderedList &other) const;
+
+    OrderedList intersect(const OrderedList &other) const;
+
+    OrderedList subtract(const OrderedList &other) const;
+
+    OrderedList symmetricDifference(const OrderedList &other) const;
+
+    // Same as above, in place
+    void uniteWith(const OrderedList &other);
+
+    void intersectWith(const OrderedList &other);
+
+    void subtractWith(const OrderedList &other);
+
+    void symmetricDifferenceWith(const OrderedList &other);
+
+private:
+    OrderedList combine(const ordered_list_detail::SetOperation &op, const OrderedList &other) const;
+
+    void combineWith(const ordered_list_detail::SetOperation &op, const OrderedList &other);
+
+    Pool &pool();
+
+    Cell *createCell(const T &elem, Cell *next);
+
+    void destroyCell(Cell *cell);
+
+    void destroyCells();
+
+    void copyCells(const OrderedList &other);
+
+    void linkCells(const std::vector<T> &values);
 };
 
-template<typename T>
-OrderedList<T>::~OrderedList() {
-    Cell *current = head;
-    while (current != nullptr) {
-        Cell *tmp = current->next;
-        delete (current);
-        current = tmp;
-    }
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>>::~OrderedList() {
+    destroyCells();
 }
 
-template<typename T>
-void OrderedList<T>::add(const T &elem) {
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::add(const T &elem) {
     Cell **insertAt = &head;
     while (*insertAt != nullptr && (**insertAt).val < elem) {
         insertAt = &((**insertAt).next);
     }
-    Cell *newCell = new Cell;
-    newCell->val = elem;
-    if (*insertAt != nullptr) {
-        newCell->next = *insertAt;
-    }
-    (*insertAt) = newCell;
+    (*insertAt) = createCell(elem, *insertAt);
 }
 
-template<typename T>
-void OrderedList<T>::addUniquely(const T &elem) {
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::addUniquely(const T &elem) {
 
     Cell **insertAt = &head;
     while (*insertAt != nullptr && (**insertAt).val < elem) {
         insertAt = &((**insertAt).next);
     }
     if (*insertAt == nullptr || (**insertAt).val != elem) {
-        Cell *newCell = new Cell;
-        newCell->val = elem;
-        if (*insertAt != nullptr) {
-            newCell->next = *insertAt;
-        }
-        (*insertAt) = newCell;
+        (*insertAt) = createCell(elem, *insertAt);
     }
 }
 
-template<typename T>
-bool OrderedList<T>::removeOne(const T &elem) {
+template<typename T, typename Allocation>
+bool OrderedList<T, LinkedCells<Allocation>>::removeOne(const T &elem) {
     Cell **lookAt = &head;
     while (*lookAt != nullptr && (**lookAt).val < elem) {
         lookAt = &((**lookAt).next);
     }
     if (*lookAt != nullptr && (**lookAt).val == elem) {
         Cell *tmp = (*lookAt)->next;
-        delete *lookAt;
+        destroyCell(*lookAt);
         *lookAt = tmp;
         return true;
     }
@@ -191,8 +486,8 @@ bool OrderedList<T>::removeOne(const T &elem) {
     return false;
 }
 
-template<typename T>
-bool OrderedList<T>::removeAll(const T &elem) {
+template<typename T, typename Allocation>
+bool OrderedList<T, LinkedCells<Allocation>>::removeAll(const T &elem) {
     bool result = false;
     Cell **lookAt = &head;
     while (*lookAt != nullptr && (**lookAt).val < elem) {
@@ -200,7 +495,7 @@ bool OrderedList<T>::removeAll(const T &elem) {
     }
     while (*lookAt != nullptr && (**lookAt).val == elem) {
         Cell *tmp = (*lookAt)->next;
-        delete *lookAt;
+        destroyCell(*lookAt);
         *lookAt = tmp;
         result = true;
     }
@@ -208,8 +503,8 @@ bool OrderedList<T>::removeAll(const T &elem) {
     return result;
 }
 
-template<typename T>
-void OrderedList<T>::display() const {
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::display() const {
     Cell *current = head;
     while (current != nullptr) {
         std::cout << current->val << " ";
@@ -218,8 +513,8 @@ void OrderedList<T>::display() const {
     std::cout << "\n";
 }
 
-template<typename T>
-bool OrderedList<T>::contains(const T &elem) const {
+template<typename T, typename Allocation>
+bool OrderedList<T, LinkedCells<Allocation>>::contains(const T &elem) const {
     Cell *const *lookAt = &head;
     while (*lookAt != nullptr && (**lookAt).val < elem) {
         lookAt = &((**lookAt).next);
@@ -227,100 +522,79 @@ bool OrderedList<T>::contains(const T &elem) const {
     return (*lookAt != nullptr && (**lookAt).val == elem);
 }
 
-template<typename T>
-typename OrderedList<T>::iterator OrderedList<T>::begin() {
+template<typename T, typename Allocation>
+typename OrderedList<T, LinkedCells<Allocation>>::iterator OrderedList<T, LinkedCells<Allocation>>::begin() {
     iterator result;
     result.source = &head;
     result.current = head;
+    result.list = this;
     return result;
 }
 
-template<typename T>
-typename OrderedList<T>::iterator OrderedList<T>::end() const {
+template<typename T, typename Allocation>
+typename OrderedList<T, LinkedCells<Allocation>>::iterator OrderedList<T, LinkedCells<Allocation>>::end() const {
     return iterator();
 }
 
-template<typename T>
-bool OrderedList<T>::isEmpty() const {
+template<typename T, typename Allocation>
+bool OrderedList<T, LinkedCells<Allocation>>::isEmpty() const {
     return head == nullptr;
 }
 
-template<typename T>
-T &OrderedList<T>::getFirst() const {
+template<typename T, typename Allocation>
+T &OrderedList<T, LinkedCells<Allocation>>::getFirst() const {
     return head->val;
 }
 
-template<typename T>
-bool OrderedList<T>::popFirst() {
+template<typename T, typename Allocation>
+bool OrderedList<T, LinkedCells<Allocation>>::popFirst() {
     if (isEmpty()) {
         return false;
     }
     Cell *tmp = head->next;
-    delete head;
+    destroyCell(head);
     head = tmp;
     return true;
 }
 
-template<typename T>
-OrderedList<T>::OrderedList(const OrderedList &other) {
-    Cell **me = &head;
-    Cell *them = other.head;
-    while (them != nullptr) {
-        *me = new Cell;
-        (*me)->val = them->val;
-        me = &((*me)->next);
-        them = them->next;
-    }
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>>::OrderedList(const OrderedList &other) : Pool() {
+    copyCells(other);
 }
 
-template<typename T>
-OrderedList<T>::OrderedList(OrderedList &&other) noexcept {
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>>::OrderedList(OrderedList &&other) noexcept {
     head = other.head;
     other.head = nullptr;
+    pool().swap(other.pool());
 }
 
-template<typename T>
-OrderedList<T> &OrderedList<T>::operator=(const OrderedList &other) {
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>> &OrderedList<T, LinkedCells<Allocation>>::operator=(const OrderedList &other) {
     if (&other != this) {
-        Cell *shuttle = head;
-        Cell *tmp;
-        while (shuttle != nullptr) {
-            tmp = shuttle->next;
-            delete shuttle;
-            shuttle = tmp;
-        }
-
-        Cell **me = &head;
-        Cell *them = other.head;
-        while (them != nullptr) {
-            *me = new Cell;
-            (*me)->val = them->val;
-            me = &((*me)->next);
-            them = them->next;
-        }
+        destroyCells();
+        pool().release();
+        copyCells(other);
     }
     return *this;
 }
 
-template<typename T>
-OrderedList<T> &OrderedList<T>::operator=(OrderedList &&other) noexcept {
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>> &
+OrderedList<T, LinkedCells<Allocation>>::operator=(OrderedList &&other) noexcept {
     if (&other != this) {
-        Cell *shuttle = head;
-        Cell *tmp;
-        while (shuttle != nullptr) {
-            tmp = shuttle->next;
-            delete shuttle;
-            shuttle = tmp;
-        }
+        destroyCells();
+        pool().release();
 
         head = other.head;
         other.head = nullptr;
+        pool().swap(other.pool());
     }
     return *this;
 }
 
-template<typename T>
-void OrderedList<T>::addAll(const OrderedList &other) {
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::addAll(const OrderedList &other) {
     iterator itThis = begin();
     const_iterator itOther = other.cbegin();
     while (itOther != cend()) {
@@ -332,17 +606,747 @@ void OrderedList<T>::addAll(const OrderedList &other) {
     }
 }
 
-template<typename T>
-typename OrderedList<T>::const_iterator OrderedList<T>::cbegin() const {
+template<typename T, typename Allocation>
+typename OrderedList<T, LinkedCells<Allocation>>::const_iterator
+OrderedList<T, LinkedCells<Allocation>>::cbegin() const {
     const_iterator result;
     result.current = head;
     return result;
 }
 
-template<typename T>
-typename OrderedList<T>::const_iterator OrderedList<T>::cend() const {
+template<typename T, typename Allocation>
+typename OrderedList<T, LinkedCells<Allocation>>::const_iterator OrderedList<T, LinkedCells<Allocation>>::cend() const {
     return const_iterator();
 }
 
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>> OrderedList<T, LinkedCells<Allocation>>::unite(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::UNION, other);
+}
+
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>>
+OrderedList<T, LinkedCells<Allocation>>::intersect(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::INTERSECTION, other);
+}
+
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>>
+OrderedList<T, LinkedCells<Allocation>>::subtract(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::DIFFERENCE, other);
+}
+
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>>
+OrderedList<T, LinkedCells<Allocation>>::symmetricDifference(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::SYMMETRIC_DIFFERENCE, other);
+}
+
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::uniteWith(const OrderedList &other) {
+    combineWith(ordered_list_detail::SetOperation::UNION, other);
+}
+
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::intersectWith(const OrderedList &other) {
+    combineWith(ordered_list_detail::SetOperation::INTERSECTION, other);
+}
+
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::subtractWith(const OrderedList &other) {
+    combineWith(ordered_list_detail::SetOperation::DIFFERENCE, other);
+}
+
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::symmetricDifferenceWith(const OrderedList &other) {
+    combineWith(ordered_list_detail::SetOperation::SYMMETRIC_DIFFERENCE, other);
+}
+
+template<typename T, typename Allocation>
+OrderedList<T, LinkedCells<Allocation>>
+OrderedList<T, LinkedCells<Allocation>>::combine(const ordered_list_detail::SetOperation &op,
+                                                const OrderedList &other) const {
+    OrderedList result;
+    Cell **tail = &result.head;
+    ordered_list_detail::merge(op, cbegin(), cend(), other.cbegin(), other.cend(), [&result, &tail](const T &elem) {
+        *tail = result.createCell(elem, nullptr);
+        tail = &((*tail)->next);
+    });
+    return result;
+}
+
+// Relinks the cells of this list, so only elements coming from other are allocated
+template<typename T, typename Allocation>
+void
+OrderedList<T, LinkedCells<Allocation>>::combineWith(const ordered_list_detail::SetOperation &op,
+                                                     const OrderedList &other) {
+    using namespace ordered_list_detail;
+    if (&other == this) {
+        if (!keepsCommon(op)) {
+            *this = OrderedList();
+        }
+        return;
+    }
+    Cell **at = &head;
+    const_iterator itOther = other.cbegin();
+    while (*at != nullptr && itOther != cend()) {
+        Cell *cell = *at;
+        if (*itOther < cell->val) {
+            if (keepsSecond(op)) {
+                Cell *newCell = createCell(*itOther, cell);
+                *at = newCell;
+                at = &(newCell->next);
+            }
+            ++itOther;
+            continue;
+        }
+        const bool common = !(cell->val < *itOther);
+        if (common ? keepsCommon(op) : keepsFirst(op)) {
+            at = &(cell->next);
+        } else {
+            *at = cell->next;
+            destroyCell(cell);
+        }
+        if (common) {
+            ++itOther;
+        }
+    }
+    while (!keepsFirst(op) && *at != nullptr) {
+        Cell *tmp = (*at)->next;
+        destroyCell(*at);
+        *at = tmp;
+    }
+    for (; keepsSecond(op) && itOther != cend(); ++itOther) {
+        *at = createCell(*itOther, nullptr);
+        at = &((*at)->next);
+    }
+}
+
+template<typename T, typename Allocation>
+typename OrderedList<T, LinkedCells<Allocation>>::Pool &OrderedList<T, LinkedCells<Allocation>>::pool() {
+    return *this;
+}
+
+template<typename T, typename Allocation>
+typename OrderedList<T, LinkedCells<Allocation>>::Cell *
+OrderedList<T, LinkedCells<Allocation>>::createCell(const T &elem, Cell *next) {
+    void *memory = pool().allocate();
+    try {
+        return new(memory) Cell{elem, next};
+    } catch (...) {
+        pool().deallocate(memory);
+        throw;
+    }
+}
+
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::destroyCell(Cell *cell) {
+    cell->~Cell();
+    pool().deallocate(cell);
+}
+
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::destroyCells() {
+    Cell *current = head;
+    while (current != nullptr) {
+        Cell *tmp = current->next;
+        destroyCell(current);
+        current = tmp;
+    }
+    head = nullptr;
+}
+
+template<typename T, typename Allocation>
+template<typename It>
+OrderedList<T, LinkedCells<Allocation>>::OrderedList(It first, It last, const bool &unique) {
+    linkCells(ordered_list_detail::sortedValues<T>(first, last, unique));
+}
+
+template<typename T, typename Allocation>
+template<typename It>
+void OrderedList<T, LinkedCells<Allocation>>::assign(It first, It last, const bool &unique) {
+    const std::vector<T> values = ordered_list_detail::sortedValues<T>(first, last, unique);
+    destroyCells();
+    pool().release();
+    linkCells(values);
+}
+
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::linkCells(const std::vector<T> &values) {
+    pool().reserve(values.size());
+    Cell **me = &head;
+    for (const T &value : values) {
+        *me = createCell(value, nullptr);
+        me = &((*me)->next);
+    }
+}
+
+// Copies into cells reserved up front, which slab pools lay out contiguously in traversal order
+template<typename T, typename Allocation>
+void OrderedList<T, LinkedCells<Allocation>>::copyCells(const OrderedList &other) {
+    size_t count = 0;
+    for (Cell *them = other.head; them != nullptr; them = them->next) {
+        count++;
+    }
+    pool().reserve(count);
+    Cell **me = &head;
+    for (Cell *them = other.head; them != nullptr; them = them->next) {
+        *me = createCell(them->val, nullptr);
+        me = &((*me)->next);
+    }
+}
+
+template<typename T, size_t B>
+class OrderedList<T, SortedBlocks<B>> {
+    static_assert(B >= 4, "SortedBlocks requires blocks of at least 4 elements");
+
+private:
+    // Bulk-built blocks leave room so that following inserts do not split right away
+    static constexpr size_t FILL = B - B / 4;
+    // One list this many times smaller than the other is looked up element by element instead of merged
+    static constexpr size_t GALLOP_RATIO = 32;
+
+    struct Block {
+        size_t count = 0;
+        T vals[B];
+    };
+    // Blocks are non-empty and ordered, so the last element of each block is a search key
+    std::vector<std::unique_ptr<Block>> blocks;
+public:
+    class iterator {
+    public:
+        OrderedList *list = nullptr;
+        size_t block = 0;
+        size_t index = 0;
+        T *current = nullptr;
+    public:
+        iterator &operator++() {
+            if (current != nullptr) {
+                index++;
+                list->settle(*this);
+            }
+            return *this;
+        }
+
+        void remove() {
+            if (current != nullptr) {
+                list->eraseAt(block, index);
+                list->settle(*this);
+            }
+        }
+
+        bool operator==(const iterator &other) const {
+            return current == other.current;
+        }
+
+        bool operator!=(const iterator &other) const {
+            return current != other.current;
+        }
+
+        T &operator*() {
+            return *current;
+        }
+
+        void insertBefore(const T &elem) {
+            if (current == nullptr) {
+                list->insertAt(block = list->blocks.size(), index, elem);
+                return;
+            }
+            list->insertAt(block, index, elem);
+            index++;
+            list->settle(*this);
+        }
+
+        void insertAfter(const T &elem) {
+            if (current == nullptr) {
+                list->insertAt(block = list->blocks.size(), index, elem);
+                return;
+            }
+            index++;
+            list->insertAt(block, index, elem);
+            // A split may have moved the current element, it is right before the new one
+            if (index == 0) {
+                block--;
+                index = list->blocks[block]->count;
+            }
+            index--;
+            list->settle(*this);
+        }
+    };
+
+    class const_iterator {
+    public:
+        const OrderedList *list = nullptr;
+        size_t block = 0;
+        size_t index = 0;
+        const T *current = nullptr;
+    public:
+        const_iterator &operator++() {
+            if (current != nullptr) {
+                index++;
+                current = list->normalize(block, index) ? &list->blocks[block]->vals[index] : nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator &other) const {
+            return current == other.current;
+        }
+
+        bool operator!=(const const_iterator &other) const {
+            return current != other.current;
+        }
+
+        const T &operator*() const {
+            return *current;
+        }
+    };
+
+public:
+    OrderedList() = default;
+
+    // Sorts a copy of [first, last), in parallel for large ranges, and builds the list in one pass. Repeated
+    // elements are kept once when unique.
+    template<typename It>
+    OrderedList(It first, It last, const bool &unique = false);
+
+    OrderedList(const OrderedList &other);
+
+    OrderedList(OrderedList &&other) noexcept = default;
+
+    OrderedList &operator=(const OrderedList &other);
+
+    OrderedList &operator=(OrderedList &&other) noexcept = default;
+
+    ~OrderedList() = default;
+
+    void add(const T &elem);
+
+    void addUniquely(const T &elem);
+
+    bool removeOne(const T &elem);
+
+    bool removeAll(const T &elem);
+
+    void addAll(const OrderedList &other);
+
+    // Replaces the content by [first, last), as the range constructor
+    template<typename It>
+    void assign(It first, It last, const bool &unique = false);
+
+    bool contains(const T &elem) const;
+
+    bool isEmpty() const;
+
+    T &getFirst() const;
+
+    bool popFirst();
+
+    iterator begin();
+
+    inline iterator end() const;
+
+    const_iterator cbegin() const;
+
+    inline const_iterator cend() const;
+
+    void display() const;
+
+    // Set algebra in O(n + m) with multiset semantics: unite keeps max(p, q) copies of an element present p times
+    // here and q times in other, intersect min(p, q), subtract max(p - q, 0) and symmetricDifference |p - q|
+    OrderedList unite(const OrderedList &other) const;
+
+    OrderedList intersect(const OrderedList &other) const;
+
+    OrderedList subtract(const OrderedList &other) const;
+
+    OrderedList symmetricDifference(const OrderedList &other) const;
+
+    // Same as above, in place
+    void uniteWith(const OrderedList &other);
+
+    void intersectWith(const OrderedList &other);
+
+    void subtractWith(const OrderedList &other);
+
+    void symmetricDifferenceWith(const OrderedList &other);
+
+private:
+    void lowerBound(const T &elem, size_t &block, size_t &index) const;
+
+    bool normalize(size_t &block, size_t &index) const;
+
+    void settle(iterator &it);
+
+    void insertAt(size_t &block, size_t &index, const T &elem);
+
+    void eraseAt(size_t &block, size_t &index);
+
+    void append(const T &elem);
+
+    size_t countElements() const;
+
+    void gallop(const T &elem, size_t &block, size_t &index) const;
+
+    template<typename Out>
+    void probe(const_iterator first, const bool &keepFound, Out &&out) const;
+
+    OrderedList combine(const ordered_list_detail::SetOperation &op, const OrderedList &other) const;
+};
+
+// Position of the first element not less than elem, block is blocks.size() when there is none
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::lowerBound(const T &elem, size_t &block, size_t &index) const {
+    block = size_t(std::partition_point(blocks.begin(), blocks.end(), [&elem](const std::unique_ptr<Block> &b) {
+        return b->vals[b->count - 1] < elem;
+    }) - blocks.begin());
+    if (block == blocks.size()) {
+        index = 0;
+        return;
+    }
+    const Block &b = *blocks[block];
+    index = size_t(std::lower_bound(b.vals, b.vals + b.count, elem) - b.vals);
+}
+
+// Moves a position past the end of its block to the start of the next one, returns whether it is an element
+template<typename T, size_t B>
+bool OrderedList<T, SortedBlocks<B>>::normalize(size_t &block, size_t &index) const {
+    if (block < blocks.size() && index == blocks[block]->count) {
+        block++;
+        index = 0;
+    }
+    return block < blocks.size();
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::settle(iterator &it) {
+    it.current = normalize(it.block, it.index) ? &blocks[it.block]->vals[it.index] : nullptr;
+}
+
+// Inserts elem before the position, which is left on the inserted element
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::insertAt(size_t &block, size_t &index, const T &elem) {
+    if (blocks.empty()) {
+        blocks.emplace_back(new Block);
+        block = 0;
+        index = 0;
+    } else if (block == blocks.size()) {
+        block--;
+        index = blocks[block]->count;
+    }
+    if (blocks[block]->count == B) {
+        blocks.emplace(blocks.begin() + block + 1, new Block);
+        Block &lower = *blocks[block];
+        Block &upper = *blocks[block + 1];
+        // Appending to the last block starts a new one, so ascending inserts fill blocks completely
+        const size_t from = block + 2 == blocks.size() && index == B ? B : B / 2;
+        std::move(lower.vals + from, lower.vals + B, upper.vals);
+        upper.count = B - from;
+        lower.count = from;
+        if (index > from || (index == from && from == B)) {
+            block++;
+            index -= from;
+        }
+    }
+    Block &b = *blocks[block];
+    std::move_backward(b.vals + index, b.vals + b.count, b.vals + b.count + 1);
+    b.vals[index] = elem;
+    b.count++;
+}
+
+// Removes the element at the position, which is left on its successor, possibly past the end of a block
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::eraseAt(size_t &block, size_t &index) {
+    Block &b = *blocks[block];
+    std::move(b.vals + index + 1, b.vals + b.count, b.vals + index);
+    b.count--;
+    if (b.count == 0) {
+        blocks.erase(blocks.begin() + block);
+        index = 0;
+    } else if (block + 1 < blocks.size() && b.count + blocks[block + 1]->count <= B / 2) {
+        Block &next = *blocks[block + 1];
+        std::move(next.vals, next.vals + next.count, b.vals + b.count);
+        b.count += next.count;
+        blocks.erase(blocks.begin() + block + 1);
+    }
+}
+
+template<typename T, size_t B>
+template<typename It>
+OrderedList<T, SortedBlocks<B>>::OrderedList(It first, It last, const bool &unique) {
+    const std::vector<T> values = ordered_list_detail::sortedValues<T>(first, last, unique);
+    blocks.reserve((values.size() + FILL - 1) / FILL);
+    for (const T &value : values) {
+        append(value);
+    }
+}
+
+template<typename T, size_t B>
+template<typename It>
+void OrderedList<T, SortedBlocks<B>>::assign(It first, It last, const bool &unique) {
+    OrderedList built(first, last, unique);
+    blocks.swap(built.blocks);
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::add(const T &elem) {
+    size_t block, index;
+    lowerBound(elem, block, index);
+    insertAt(block, index, elem);
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::addUniquely(const T &elem) {
+    size_t block, index;
+    lowerBound(elem, block, index);
+    if (block == blocks.size() || blocks[block]->vals[index] != elem) {
+        insertAt(block, index, elem);
+    }
+}
+
+template<typename T, size_t B>
+bool OrderedList<T, SortedBlocks<B>>::removeOne(const T &elem) {
+    size_t block, index;
+    lowerBound(elem, block, index);
+    if (block < blocks.size() && blocks[block]->vals[index] == elem) {
+        eraseAt(block, index);
+        return true;
+    }
+    return false;
+}
+
+template<typename T, size_t B>
+bool OrderedList<T, SortedBlocks<B>>::removeAll(const T &elem) {
+    bool result = false;
+    size_t block, index;
+    lowerBound(elem, block, index);
+    while (normalize(block, index) && blocks[block]->vals[index] == elem) {
+        eraseAt(block, index);
+        result = true;
+    }
+    return result;
+}
+
+// Merges both lists into freshly packed blocks, equal elements of other go first as with LinkedCells
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::addAll(const OrderedList &other) {
+    OrderedList merged;
+    const_iterator itThis = cbegin();
+    const_iterator itOther = other.cbegin();
+    while (itThis != cend() || itOther != cend()) {
+        if (itOther != cend() && (itThis == cend() || !(*itThis < *itOther))) {
+            merged.append(*itOther);
+            ++itOther;
+        } else {
+            merged.append(*itThis);
+            ++itThis;
+        }
+    }
+    blocks.swap(merged.blocks);
+}
+
+template<typename T, size_t B>
+bool OrderedList<T, SortedBlocks<B>>::contains(const T &elem) const {
+    size_t block, index;
+    lowerBound(elem, block, index);
+    return block < blocks.size() && blocks[block]->vals[index] == elem;
+}
+
+template<typename T, size_t B>
+bool OrderedList<T, SortedBlocks<B>>::isEmpty() const {
+    return blocks.empty();
+}
+
+template<typename T, size_t B>
+T &OrderedList<T, SortedBlocks<B>>::getFirst() const {
+    return blocks.front()->vals[0];
+}
+
+template<typename T, size_t B>
+bool OrderedList<T, SortedBlocks<B>>::popFirst() {
+    if (isEmpty()) {
+        return false;
+    }
+    size_t block = 0, index = 0;
+    eraseAt(block, index);
+    return true;
+}
+
+template<typename T, size_t B>
+typename OrderedList<T, SortedBlocks<B>>::iterator OrderedList<T, SortedBlocks<B>>::begin() {
+    iterator result;
+    result.list = this;
+    settle(result);
+    return result;
+}
+
+template<typename T, size_t B>
+typename OrderedList<T, SortedBlocks<B>>::iterator OrderedList<T, SortedBlocks<B>>::end() const {
+    return iterator();
+}
+
+template<typename T, size_t B>
+typename OrderedList<T, SortedBlocks<B>>::const_iterator OrderedList<T, SortedBlocks<B>>::cbegin() const {
+    const_iterator result;
+    result.list = this;
+    result.current = blocks.empty() ? nullptr : &blocks.front()->vals[0];
+    return result;
+}
+
+template<typename T, size_t B>
+typename OrderedList<T, SortedBlocks<B>>::const_iterator OrderedList<T, SortedBlocks<B>>::cend() const {
+    return const_iterator();
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::display() const {
+    for (const_iterator it = cbegin(); it != cend(); ++it) {
+        std::cout << *it << " ";
+    }
+    std::cout << "\n";
+}
+
+template<typename T, size_t B>
+OrderedList<T, SortedBlocks<B>>::OrderedList(const OrderedList &other) {
+    blocks.reserve(other.blocks.size());
+    for (const auto &b : other.blocks) {
+        blocks.emplace_back(new Block(*b));
+    }
+}
+
+template<typename T, size_t B>
+OrderedList<T, SortedBlocks<B>> &OrderedList<T, SortedBlocks<B>>::operator=(const OrderedList &other) {
+    if (&other != this) {
+        OrderedList copy(other);
+        blocks.swap(copy.blocks);
+    }
+    return *this;
+}
+
+
+template<typename T, size_t B>
+OrderedList<T, SortedBlocks<B>> OrderedList<T, SortedBlocks<B>>::unite(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::UNION, other);
+}
+
+template<typename T, size_t B>
+OrderedList<T, SortedBlocks<B>> OrderedList<T, SortedBlocks<B>>::intersect(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::INTERSECTION, other);
+}
+
+template<typename T, size_t B>
+OrderedList<T, SortedBlocks<B>> OrderedList<T, SortedBlocks<B>>::subtract(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::DIFFERENCE, other);
+}
+
+template<typename T, size_t B>
+OrderedList<T, SortedBlocks<B>> OrderedList<T, SortedBlocks<B>>::symmetricDifference(const OrderedList &other) const {
+    return combine(ordered_list_detail::SetOperation::SYMMETRIC_DIFFERENCE, other);
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::uniteWith(const OrderedList &other) {
+    *this = combine(ordered_list_detail::SetOperation::UNION, other);
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::intersectWith(const OrderedList &other) {
+    *this = combine(ordered_list_detail::SetOperation::INTERSECTION, other);
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::subtractWith(const OrderedList &other) {
+    *this = combine(ordered_list_detail::SetOperation::DIFFERENCE, other);
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::symmetricDifferenceWith(const OrderedList &other) {
+    *this = combine(ordered_list_detail::SetOperation::SYMMETRIC_DIFFERENCE, other);
+}
+
+template<typename T, size_t B>
+OrderedList<T, SortedBlocks<B>>
+OrderedList<T, SortedBlocks<B>>::combine(const ordered_list_detail::SetOperation &op, const OrderedList &other) const {
+    using namespace ordered_list_detail;
+    OrderedList result;
+    auto out = [&result](const T &elem) {
+        result.append(elem);
+    };
+    // Skewed intersections and differences look the few elements up in the larger list, skipping most of it
+    const size_t mine = countElements();
+    const size_t theirs = other.countElements();
+    if ((op == SetOperation::INTERSECTION || op == SetOperation::DIFFERENCE) && mine * GALLOP_RATIO < theirs) {
+        other.probe(cbegin(), op == SetOperation::INTERSECTION, out);
+    } else if (op == SetOperation::INTERSECTION && theirs * GALLOP_RATIO < mine) {
+        probe(other.cbegin(), true, out);
+    } else {
+        merge(op, cbegin(), cend(), other.cbegin(), other.cend(), out);
+    }
+    return result;
+}
+
+// Looks the sorted elements of [first, cend()) up in this list, each match being used once, and outputs the ones
+// found when keepFound, the others otherwise
+template<typename T, size_t B>
+template<typename Out>
+void OrderedList<T, SortedBlocks<B>>::probe(const_iterator first, const bool &keepFound, Out &&out) const {
+    size_t block = 0, index = 0;
+    for (; first != cend(); ++first) {
+        gallop(*first, block, index);
+        const bool found = normalize(block, index) && !(*first < blocks[block]->vals[index]);
+        if (found) {
+            index++;
+        }
+        if (found == keepFound) {
+            out(*first);
+        }
+    }
+}
+
+// Moves the position forward to the first element not less than elem, in O(log distance)
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::gallop(const T &elem, size_t &block, size_t &index) const {
+    const auto before = [&elem](const std::unique_ptr<Block> &b) {
+        return b->vals[b->count - 1] < elem;
+    };
+    if (block >= blocks.size()) {
+        return;
+    }
+    if (before(blocks[block])) {
+        size_t low = block;
+        size_t step = 1;
+        while (low + step < blocks.size() && before(blocks[low + step])) {
+            low += step;
+            step *= 2;
+        }
+        const size_t high = std::min(low + step, blocks.size());
+        block = size_t(std::partition_point(blocks.begin() + low + 1, blocks.begin() + high, before) - blocks.begin());
+        index = 0;
+        if (block == blocks.size()) {
+            return;
+        }
+    }
+    const Block &b = *blocks[block];
+    index = size_t(std::lower_bound(b.vals + index, b.vals + b.count, elem) - b.vals);
+}
+
+template<typename T, size_t B>
+void OrderedList<T, SortedBlocks<B>>::append(const T &elem) {
+    if (blocks.empty() || blocks.back()->count == FILL) {
+        blocks.emplace_back(new Block);
+    }
+    Block &b = *blocks.back();
+    b.vals[b.count++] = elem;
+}
+
+template<typename T, size_t B>
+size_t OrderedList<T, SortedBlocks<B>>::countElements() const {
+    size_t result = 0;
+    for (const auto &b : blocks) {
+        result += b->count;
+    }
+    return result;
+}
+
 
 #endif //LISTSGRAPH_ORDEREDLIST_HPP
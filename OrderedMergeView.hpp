@@ -0,0 +1,154 @@
+//
+// Lazy sorted union of many OrderedLists
+//
+// The view only keeps pointers to the lists, which must outlive it and stay unchanged while it is iterated. Its
+// iterator merges the lists' const_iterators through a loser tree: each step replays one leaf-to-root path, so
+// yielding an element costs log2(k) comparisons for k lists and allocates nothing. Iterators are single-pass.
+//
+
+#ifndef CPP_UTILS_ORDEREDMERGEVIEW_H
+#define CPP_UTILS_ORDEREDMERGEVIEW_H
+
+#include <cstdlib> // size_t
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "OrderedList.hpp"
+
+template<typename List>
+class OrderedMergeView {
+private:
+    using ListIterator = typename List::const_iterator;
+    using Element = std::remove_reference_t<decltype(*std::declval<const ListIterator &>())>;
+
+public:
+    class const_iterator {
+    public:
+        const_iterator() = default;
+
+        const_iterator &operator++() {
+            if (current != nullptr) {
+                Element *previous = current;
+                advance();
+                // Lists are sorted, so anything not greater than the previous element equals it
+                while (unique && current != nullptr && !(*previous < *current)) {
+                    advance();
+                }
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator &other) const {
+            return current == other.current;
+        }
+
+        bool operator!=(const const_iterator &other) const {
+            return current != other.current;
+        }
+
+        Element &operator*() const {
+            return *current;
+        }
+
+    private:
+        friend class OrderedMergeView;
+
+        struct Cursor {
+            ListIterator at;
+            ListIterator end;
+        };
+
+        const_iterator(const std::vector<const List *> &lists, const bool &unique) : unique(unique) {
+            cursors.reserve(lists.size());
+            for (const List *list : lists) {
+                cursors.push_back({list->cbegin(), list->cend()});
+            }
+            if (cursors.empty()) {
+                return;
+            }
+            tree.resize(cursors.size());
+            tree[0] = build(1);
+            settle();
+        }
+
+        // Whether cursor a goes before cursor b, exhausted cursors going last and ties in list order
+        bool before(const size_t &a, const size_t &b) const {
+            if (cursors[a].at == cursors[a].end) {
+                return false;
+            }
+            if (cursors[b].at == cursors[b].end) {
+                return true;
+            }
+            return *cursors[a].at < *cursors[b].at || (!(*cursors[b].at < *cursors[a].at) && a < b);
+        }
+
+        // Leaves are the nodes [k, 2k), each internal node keeps the loser of its subtree and returns the winner
+        size_t build(const size_t &node) {
+            if (node >= cursors.size()) {
+                return node - cursors.size();
+            }
+            const size_t left = build(2 * node);
+            const size_t right = build(2 * node + 1);
+            if (before(right, left)) {
+                tree[node] = left;
+                return right;
+            }
+            tree[node] = right;
+            return left;
+        }
+
+        void advance() {
+            size_t winner = tree[0];
+            ++cursors[winner].at;
+            for (size_t node = (winner + cursors.size()) / 2; node > 0; node /= 2) {
+                if (before(tree[node], winner)) {
+                    std::swap(tree[node], winner);
+                }
+            }
+            tree[0] = winner;
+            settle();
+        }
+
+        void settle() {
+            const Cursor &winner = cursors[tree[0]];
+            current = winner.at == winner.end ? nullptr : &*winner.at;
+        }
+
+        std::vector<Cursor> cursors;
+        // tree[0] is the winner, tree[1..k) the losers of the internal nodes
+        std::vector<size_t> tree;
+        Element *current = nullptr;
+        bool unique = false;
+    };
+
+public:
+    explicit OrderedMergeView(const bool &unique = false) : unique(unique) {}
+
+    // View over every list of [first, last)
+    template<typename It>
+    OrderedMergeView(It first, It last, const bool &unique = false) : unique(unique) {
+        for (; first != last; ++first) {
+            lists.push_back(&*first);
+        }
+    }
+
+    OrderedMergeView &add(const List &list) {
+        lists.push_back(&list);
+        return *this;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(lists, unique);
+    }
+
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+private:
+    std::vector<const List *> lists;
+    bool unique;
+};
+
+#endif //CPP_UTILS_ORDEREDMERGEVIEW_H
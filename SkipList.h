@@ -5,25 +5,259 @@
 #ifndef CPP_UTILS_SKIPLIST_H
 #define CPP_UTILS_SKIPLIST_H
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-template<typename T, typename V>
+#if __cplusplus >= 202002L
+#include <bit>
+#endif
+
+// xorshift64* generator, the default level source of SkipList
+class Xorshift64Star {
+public:
+    using result_type = uint64_t;
+
+    explicit Xorshift64Star(const uint64_t &seed = 0x9e3779b97f4a7c15ull) : _state(seed != 0 ? seed : 1) {}
+
+    static constexpr result_type min() {
+        return 1;
+    }
+
+    static constexpr result_type max() {
+        return ~result_type(0);
+    }
+
+    result_type operator()() {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 0x2545f4914f6cdd1dull;
+    }
+
+private:
+    uint64_t _state;
+};
+
+namespace skiplist_detail {
+
+    template<typename C, typename = void>
+    struct is_transparent : std::false_type {
+    };
+
+    template<typename C>
+    struct is_transparent<C, std::void_t<typename C::is_transparent>> : std::true_type {
+    };
+}
+
+// Random must be constructible from a uint64_t seed and return at least 32 random bits per call.
+// With a transparent Compare (the default std::less<>), lookups accept any type comparable with V.
+// Every link also counts the nodes it skips, which gives at_rank, rank_of and percentile in O(log n).
+//
+// snapshot() freezes the current content in O(1). Snapshots can be iterated and released from other threads while
+// a single writer keeps modifying the list: nodes removed after a snapshot was taken stay linked, hidden from the
+// list, until every snapshot that sees them is released. The list must outlive its snapshots and not be moved while
+// it holds some.
+template<typename T, typename V, typename Random = Xorshift64Star, typename Compare = std::less<>>
 class SkipList {
 private:
+    static constexpr size_t MAX_LEVEL = 32;
+    static constexpr uint64_t LIVE = ~uint64_t(0);
+
+    class Node;
+
+    // Links are stored with release and read with acquire by snapshot readers, the writer reads them relaxed
+    using Link = std::atomic<Node *>;
+
+    // One level of a tower: the next node on that level, and the number of live nodes after this one up to and
+    // including next, or up to the end of the list when next is null
+    struct Step {
+        Link next;
+        size_t width;
+    };
+
+    // Header of a node, its tower of _height steps follows it in the same allocation.
+    // _born and _died are the list versions at which the node was inserted and removed.
     class Node {
     public:
-        Node() = default;
+        template<typename K, typename... Args>
+        Node(const size_t &height, K &&val, Args &&...args) : _data(std::forward<Args>(args)...),
+                                                              _val(std::forward<K>(val)), _height(height) {}
+
+        ~Node() = default;
 
-        Node(const T &data, const V &val) {
-            _data = data;
-            _val = val;
+        Link &link(const size_t &level) {
+            return tower(this)[level].next;
         }
 
-        ~Node() = default;
+        size_t &width(const size_t &level) {
+            return tower(this)[level].width;
+        }
+
+        Node *next(const size_t &level) {
+            return link(level).load(std::memory_order_relaxed);
+        }
+
+        bool dead() const {
+            return _died.load(std::memory_order_relaxed) != LIVE;
+        }
+
+        bool visible_at(const uint64_t &version) const {
+            return _born <= version && _died.load(std::memory_order_relaxed) > version;
+        }
+
+        static Step *tower(void *node) {
+            return reinterpret_cast<Step *>(static_cast<char *>(node) + TOWER_OFFSET);
+        }
+
+        T _data;
+        V _val;
+        uint64_t _born = 0;
+        std::atomic<uint64_t> _died{LIVE};
+        size_t _height = 0;
+    };
+
+    static constexpr size_t NODE_ALIGN = alignof(Node) > alignof(Step) ? alignof(Node) : alignof(Step);
+    static constexpr size_t TOWER_OFFSET = (sizeof(Node) + alignof(Step) - 1) / alignof(Step) * alignof(Step);
+    static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+    // Slab allocator for nodes, freed nodes are kept per tower height and reused before new slab space is carved
+    class NodeArena {
+    public:
+        NodeArena() = default;
+
+        NodeArena(const NodeArena &) = delete;
+
+        NodeArena &operator=(const NodeArena &) = delete;
+
+        ~NodeArena() {
+            for (void *slab : _slabs) {
+                ::operator delete(slab, std::align_val_t(NODE_ALIGN));
+            }
+        }
+
+        void *allocate(const size_t &height) {
+            Node *&recycled = _free[height - 1];
+            if (recycled != nullptr) {
+                void *node = recycled;
+                recycled = Node::tower(node)[0].next.load(std::memory_order_relaxed);
+                return node;
+            }
+            const size_t bytes = node_size(height);
+            if (_cursor == nullptr || size_t(_end - _cursor) < bytes) {
+                const size_t slab_size = bytes > SLAB_SIZE ? bytes : SLAB_SIZE;
+                _slabs.reserve(_slabs.size() + 1);
+                _cursor = static_cast<char *>(::operator new(slab_size, std::align_val_t(NODE_ALIGN)));
+                _end = _cursor + slab_size;
+                _slabs.push_back(_cursor);
+            }
+            void *node = _cursor;
+            _cursor += bytes;
+            return node;
+        }
+
+        // Takes back the storage of a destroyed node
+        void deallocate(void *node, const size_t &height) {
+            Node::tower(node)[0].next.store(_free[height - 1], std::memory_order_relaxed);
+            _free[height - 1] = static_cast<Node *>(node);
+        }
+
+        // Takes over the slabs and free nodes of other, which is left empty
+        void absorb(NodeArena &other) {
+            if (_slabs.empty()) {
+                _slabs.swap(other._slabs);
+            } else {
+                _slabs.insert(_slabs.end(), other._slabs.begin(), other._slabs.end());
+                other._slabs.clear();
+            }
+            for (size_t i = 0; i < MAX_LEVEL; ++i) {
+                Node *recycled = other._free[i];
+                other._free[i] = nullptr;
+                if (recycled == nullptr) {
+                    continue;
+                }
+                Node *tail = recycled;
+                while (tail->next(0) != nullptr) {
+                    tail = tail->next(0);
+                }
+                tail->link(0).store(_free[i], std::memory_order_relaxed);
+                _free[i] = recycled;
+            }
+            if (other._end - other._cursor > _end - _cursor) {
+                _cursor = other._cursor;
+                _end = other._end;
+            }
+            other._cursor = nullptr;
+            other._end = nullptr;
+        }
+
+        void swap(NodeArena &other) noexcept {
+            _slabs.swap(other._slabs);
+            std::swap(_cursor, other._cursor);
+            std::swap(_end, other._end);
+            std::swap_ranges(_free, _free + MAX_LEVEL, other._free);
+        }
+
+    private:
+        static size_t node_size(const size_t &height) {
+            return (TOWER_OFFSET + height * sizeof(Step) + NODE_ALIGN - 1) / NODE_ALIGN * NODE_ALIGN;
+        }
+
+        std::vector<void *> _slabs = {};
+        char *_cursor = nullptr;
+        char *_end = nullptr;
+        Node *_free[MAX_LEVEL] = {};
+    };
+
+    // Versions of the snapshots held on a list, released from any thread
+    class SnapshotRegistry {
+    public:
+        static constexpr uint64_t NONE = ~uint64_t(0);
+
+        void acquire(const uint64_t &version) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _versions.push_back(version);
+            publish();
+        }
+
+        void release(const uint64_t &version) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _versions.erase(std::lower_bound(_versions.begin(), _versions.end(), version));
+            publish();
+        }
+
+        // NONE when no snapshot is held
+        uint64_t oldest() const {
+            return _oldest.load(std::memory_order_acquire);
+        }
+
+        // 0 when no snapshot is held
+        uint64_t newest() const {
+            return _newest.load(std::memory_order_acquire);
+        }
 
-        std::vector<Node *> _list = {};
-        T _data = {};
-        V _val = {};
+    private:
+        void publish() {
+            _oldest.store(_versions.empty() ? NONE : _versions.front(), std::memory_order_release);
+            _newest.store(_versions.empty() ? 0 : _versions.back(), std::memory_order_release);
+        }
+
+        std::mutex _mutex;
+        std::deque<uint64_t> _versions = {};
+        std::atomic<uint64_t> _oldest{NONE};
+        std::atomic<uint64_t> _newest{0};
     };
 
 public:
@@ -36,7 +270,7 @@ public:
         ~Iterator() = default;
 
         Iterator &operator++() {
-            _at = _at->_list[0];
+            _at = skip_dead(_at->next(0));
             return *this;
         }
 
@@ -52,30 +286,227 @@ public:
             return _at->_data;
         }
 
+        T *operator->() {
+            return &_at->_data;
+        }
+
+        const V &key() const {
+            return _at->_val;
+        }
+
     private:
         Node *_at;
     };
 
+    // Half-open run of nodes [begin, end), usable in range-based for loops
+    class Range {
+    public:
+        Range(const Iterator &begin, const Iterator &end) : _begin(begin), _end(end) {}
+
+        Iterator begin() const {
+            return _begin;
+        }
+
+        Iterator end() const {
+            return _end;
+        }
+
+    private:
+        Iterator _begin;
+        Iterator _end;
+    };
+
+    // Read-only view of the list at the version it was taken, released on destruction
+    class Snapshot {
+    public:
+        class Iterator {
+        public:
+            Iterator(Node *at, const uint64_t &version) : _at(at), _version(version) {}
+
+            Iterator &operator++() {
+                _at = skip_invisible(_at->link(0).load(std::memory_order_acquire), _version);
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const {
+                return _at == other._at;
+            }
+
+            bool operator!=(const Iterator &other) const {
+                return _at != other._at;
+            }
+
+            const T &operator*() const {
+                return _at->_data;
+            }
+
+            const T *operator->() const {
+                return &_at->_data;
+            }
+
+            const V &key() const {
+                return _at->_val;
+            }
+
+        private:
+            Node *_at;
+            uint64_t _version;
+        };
+
+        Snapshot(const Snapshot &) = delete;
+
+        Snapshot(Snapshot &&other) noexcept : _list(other._list), _version(other._version) {
+            other._list = nullptr;
+        }
+
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        Snapshot &operator=(Snapshot &&other) noexcept {
+            if (this != &other) {
+                release();
+                _list = other._list;
+                _version = other._version;
+                other._list = nullptr;
+            }
+            return *this;
+        }
+
+        ~Snapshot() {
+            release();
+        }
+
+        Iterator begin() const {
+            return Iterator(skip_invisible(_list->_head[0].next.load(std::memory_order_acquire), _version), _version);
+        }
+
+        Iterator end() const {
+            return Iterator(nullptr, _version);
+        }
+
+        // First node seen by the snapshot whose key is not less than val
+        template<typename K = V>
+        Iterator lower_bound(const K &val) const {
+            const auto &key = _list->lookup_key(val);
+            Step *insert_after = _list->_head;
+            for (size_t level = MAX_LEVEL; level-- > 0;) {
+                Node *lookup = insert_after[level].next.load(std::memory_order_acquire);
+                while (lookup != nullptr && _list->_compare(lookup->_val, key)) {
+                    insert_after = Node::tower(lookup);
+                    lookup = insert_after[level].next.load(std::memory_order_acquire);
+                }
+            }
+            return Iterator(skip_invisible(insert_after[0].next.load(std::memory_order_acquire), _version), _version);
+        }
+
+        template<typename K = V>
+        Iterator find(const K &val) const {
+            Iterator found = lower_bound(val);
+            return found != end() && !_list->_compare(_list->lookup_key(val), found.key()) ? found : end();
+        }
+
+        // Drops the snapshot early, it must not be used afterwards
+        void release() {
+            if (_list != nullptr) {
+                _list->_registry->release(_version);
+                _list = nullptr;
+            }
+        }
+
+    private:
+        friend class SkipList;
+
+        Snapshot(SkipList *list, const uint64_t &version) : _list(list), _version(version) {}
+
+        static Node *skip_invisible(Node *node, const uint64_t &version) {
+            while (node != nullptr && !node->visible_at(version)) {
+                node = node->link(0).load(std::memory_order_acquire);
+            }
+            return node;
+        }
+
+        SkipList *_list;
+        uint64_t _version;
+    };
+
 public:
-    explicit SkipList() {
-        _head = new Node();
-        _head->_list.push_back(nullptr);
-        _list_level = 0;
+    explicit SkipList(const Compare &compare = Compare()) : _random(std::random_device()()), _compare(compare) {}
+
+    // Same seed, ratio and insertion sequence give the same towers
+    explicit SkipList(const uint64_t &seed, const Compare &compare = Compare()) : _random(seed), _compare(compare) {}
+
+    SkipList(const SkipList &) = delete;
+
+    SkipList(SkipList &&other) noexcept : _list_level(other._list_level), _size(other._size), _ratio(other._ratio),
+                                          _ratio_bits(other._ratio_bits), _random(other._random),
+                                          _compare(other._compare), _version(other._version), _front(other._front),
+                                          _dead(std::move(other._dead)), _retired(std::move(other._retired)),
+                                          _registry(std::move(other._registry)) {
+        for (size_t level = 0; level < MAX_LEVEL; ++level) {
+            _head[level].next.store(other.load(other._head[level]), std::memory_order_relaxed);
+            _head[level].width = other._head[level].width;
+            other._head[level].next.store(nullptr, std::memory_order_relaxed);
+        }
+        other._list_level = 0;
+        other._size = 0;
+        other._front = nullptr;
+        other._dead.clear();
+        other._retired.clear();
+        _arena.absorb(other._arena);
+    }
+
+    SkipList &operator=(const SkipList &) = delete;
+
+    SkipList &operator=(SkipList &&other) noexcept {
+        if (this != &other) {
+            SkipList tmp(std::move(other));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    void swap(SkipList &other) noexcept {
+        for (size_t level = 0; level < MAX_LEVEL; ++level) {
+            other._head[level].next.store(
+                    _head[level].next.exchange(other.load(other._head[level]), std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            std::swap(_head[level].width, other._head[level].width);
+        }
+        std::swap(_list_level, other._list_level);
+        std::swap(_size, other._size);
+        std::swap(_ratio, other._ratio);
+        std::swap(_ratio_bits, other._ratio_bits);
+        std::swap(_random, other._random);
+        std::swap(_compare, other._compare);
+        std::swap(_version, other._version);
+        std::swap(_front, other._front);
+        _dead.swap(other._dead);
+        _retired.swap(other._retired);
+        _registry.swap(other._registry);
+        _arena.swap(other._arena);
+    }
+
+    // Builds a list from (data, key) pairs sorted by key, see append_sorted
+    template<typename InputIt>
+    static SkipList from_sorted(InputIt first, InputIt last, const bool &deterministic = false) {
+        SkipList list;
+        list.append_sorted(first, last, deterministic);
+        return list;
     }
 
     ~SkipList() {
-        Node *tmp1;
-        Node *tmp2;
-        tmp1 = _head;
-        while (tmp1 != nullptr) {
-            tmp2 = tmp1->_list[0];
-            delete tmp1;
-            tmp1 = tmp2;
+        Node *tmp = load(_head[0]);
+        while (tmp != nullptr) {
+            Node *next = tmp->next(0);
+            tmp->~Node();
+            tmp = next;
+        }
+        for (const auto &retired : _retired) {
+            retired.first->~Node();
         }
     }
 
     Iterator begin() {
-        return Iterator(_head->_list[0]);
+        return Iterator(first_live());
     }
 
     Iterator end() {
@@ -84,65 +515,590 @@ public:
 
     SkipList &set_ratio(const int &ratio) {
         _ratio = ratio;
+        _ratio_bits = 0;
+        if (ratio > 1 && (ratio & (ratio - 1)) == 0) {
+            while ((1 << _ratio_bits) < ratio) {
+                _ratio_bits++;
+            }
+        }
+        return *this;
+    }
+
+    SkipList &set_seed(const uint64_t &seed) {
+        _random = Random(seed);
         return *this;
     }
 
     // Add, Pop
-    void add(const T &data, const V &val) {
-        Node *new_node = new Node(data, val);
+    // data and val are forwarded, rvalues are moved into the node
+    template<typename D, typename K>
+    void add(D &&data, K &&val) {
+        emplace(std::forward<K>(val), std::forward<D>(data));
+    }
 
-        std::vector<Node *> path_to(_list_level + 1, nullptr);
-        size_t level = _list_level;
+    // Constructs the data of a new node keyed val in place from args
+    template<typename... Args>
+    void emplace(const V &val, Args &&...args) {
+        collect();
+        Step *path_to[MAX_LEVEL];
+        size_t rank[MAX_LEVEL];
+        find_path(val, path_to, true, rank);
+        insert(path_to, rank, true, val, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void emplace(V &&val, Args &&...args) {
+        collect();
+        Step *path_to[MAX_LEVEL];
+        size_t rank[MAX_LEVEL];
+        find_path(val, path_to, true, rank);
+        insert(path_to, rank, true, std::move(val), std::forward<Args>(args)...);
+    }
+
+    // Overwrites the data of the first node keyed val if there is one, returns true when a node was inserted.
+    // A node seen by a snapshot is replaced by a new node instead.
+    template<typename D>
+    bool add_or_update(D &&data, const V &val) {
+        collect();
+        Step *path_to[MAX_LEVEL];
+        size_t rank[MAX_LEVEL];
+        Node *found = find_path(val, path_to, false, rank);
+        while (found != nullptr && found->dead() && !_compare(val, found->_val)) {
+            found = step_over(found, path_to, rank);
+        }
+        if (found == nullptr || _compare(val, found->_val)) {
+            insert(path_to, rank, false, val, std::forward<D>(data));
+            return true;
+        }
+        if (!seen_by_snapshot(found)) {
+            found->_data = std::forward<D>(data);
+            return false;
+        }
+        retain(found, path_to);
+        insert(path_to, rank, false, val, std::forward<D>(data));
+        return false;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    T pop() {
+        collect();
+        Node *first = first_live();
+        Step *path_to[MAX_LEVEL];
+        if (first == load(_head[0])) {
+            // The first node is reached or skipped by the head on every level
+            std::fill(path_to, path_to + _list_level + 1, static_cast<Step *>(_head));
+        } else {
+            find_links(first, path_to);
+        }
+        // Snapshots require copyable data, which stays in the node for them
+        if constexpr (std::is_copy_constructible<T>::value) {
+            if (seen_by_snapshot(first)) {
+                T result = first->_data;
+                retain(first, path_to);
+                _front = first->next(0);
+                return result;
+            }
+        }
+        T result = std::move(first->_data);
+        unlink(first, path_to);
+        return result;
+    }
+
+    // O(1) read-only view of the current content, see the class comment. Must be taken by the writer.
+    Snapshot snapshot() {
+        static_assert(std::is_copy_constructible<T>::value, "SkipList snapshots require copy constructible data");
+        collect();
+        if (_registry == nullptr) {
+            _registry = std::make_unique<SnapshotRegistry>();
+        }
+        const uint64_t version = _version++;
+        _registry->acquire(version);
+        return Snapshot(this, version);
+    }
+
+    // Bulk construction
+    // Appends (data, key) pairs in a single linear pass, keys must be sorted and not below the current last key.
+    // deterministic gives the i-th node one level per power of _ratio dividing i instead of a random height.
+    // Elements are moved from when the iterators yield rvalues, as std::move_iterator does.
+    template<typename InputIt>
+    SkipList &append_sorted(InputIt first, InputIt last, const bool &deterministic = false) {
+        collect();
+        Step *tails[MAX_LEVEL];
+        size_t rank[MAX_LEVEL];
+        Node *last_node = find_tails(tails, rank);
+        size_t index = _size;
+        try {
+            for (; first != last; ++first) {
+                auto &&element = *first;
+                if (last_node != nullptr && _compare(element.second, last_node->_val)) {
+                    throw std::invalid_argument(
+                            "SkipList::append_sorted(first, last) requires keys in non-decreasing order");
+                }
+                const size_t height = deterministic ? balanced_height(++index) : random_height();
+                Node *new_node = create_node(height, std::forward<decltype(element)>(element).second,
+                                             std::forward<decltype(element)>(element).first);
+                _size++;
+                for (size_t level = 0; level < height; ++level) {
+                    tails[level][level].width = _size - rank[level];
+                    publish(tails[level][level], new_node);
+                    tails[level] = Node::tower(new_node);
+                    rank[level] = _size;
+                }
+                _list_level = height - 1 > _list_level ? height - 1 : _list_level;
+                last_node = new_node;
+            }
+        } catch (...) {
+            close_tails(tails, rank);
+            throw;
+        }
+        close_tails(tails, rank);
+        return *this;
+    }
+
+    // Splices every node of other into this list in linear time, equal keys keep the nodes of this list first.
+    // Nodes are linked one at a time in front of their successor, so snapshots of this list stay consistent.
+    SkipList &merge(SkipList &&other) {
+        if (&other == this) {
+            return *this;
+        }
+        if (other._registry != nullptr && other._registry->oldest() != SnapshotRegistry::NONE) {
+            throw std::invalid_argument("SkipList::merge(other) requires other to hold no snapshot");
+        }
+        collect();
+        other.collect();
+        _arena.absorb(other._arena);
+        Step *tails[MAX_LEVEL];
+        std::fill(tails, tails + MAX_LEVEL, static_cast<Step *>(_head));
+        Node *node = load(other._head[0]);
+        while (node != nullptr) {
+            Node *next = node->next(0);
+            node->_born = _version;
+            // Each tail only moves forward, so every level is walked once over the whole merge
+            for (size_t level = 0; level < node->_height; ++level) {
+                Node *after = load(tails[level][level]);
+                while (after != nullptr && !_compare(node->_val, after->_val)) {
+                    tails[level] = Node::tower(after);
+                    after = load(tails[level][level]);
+                }
+                node->link(level).store(after, std::memory_order_relaxed);
+                publish(tails[level][level], node);
+                tails[level] = Node::tower(node);
+            }
+            node = next;
+        }
+        _list_level = other._list_level > _list_level ? other._list_level : _list_level;
+        _size += other._size;
+        _front = nullptr;
+        rebuild_widths();
+        for (Step &step : other._head) {
+            step.next.store(nullptr, std::memory_order_relaxed);
+        }
+        other._list_level = 0;
+        other._size = 0;
+        other._front = nullptr;
+        return *this;
+    }
+
+    // Lookup, Erase
+    template<typename K = V>
+    Iterator find(const K &val) {
+        const auto &key = lookup_key(val);
+        Node *found = skip_dead(lower_bound_node(key));
+        return Iterator(found != nullptr && !_compare(key, found->_val) ? found : nullptr);
+    }
+
+    template<typename K = V>
+    bool contains(const K &val) {
+        return find(val) != end();
+    }
+
+    // First node whose key is not less than val
+    template<typename K = V>
+    Iterator lower_bound(const K &val) {
+        return Iterator(skip_dead(lower_bound_node(lookup_key(val))));
+    }
+
+    // First node whose key is greater than val
+    template<typename K = V>
+    Iterator upper_bound(const K &val) {
+        Step *path_to[MAX_LEVEL];
+        return Iterator(skip_dead(find_path(lookup_key(val), path_to, true)));
+    }
+
+    // Nodes keyed in [low, high)
+    template<typename K = V>
+    Range range(const K &low, const K &high) {
+        const auto &low_key = lookup_key(low);
+        const auto &high_key = lookup_key(high);
+        Iterator first = Iterator(skip_dead(lower_bound_node(low_key)));
+        if (!_compare(low_key, high_key)) {
+            return Range(first, first);
+        }
+        return Range(first, Iterator(skip_dead(lower_bound_node(high_key))));
+    }
+
+    // Removes every node keyed val, returns the number of removed nodes
+    template<typename K = V>
+    size_t erase(const K &val) {
+        collect();
+        const auto &key = lookup_key(val);
+        Step *path_to[MAX_LEVEL];
+        Node *found = find_path(key, path_to, false);
+        size_t count = 0;
+        while (found != nullptr && !_compare(key, found->_val)) {
+            if (found->dead()) {
+                found = step_over(found, path_to);
+                continue;
+            }
+            count++;
+            if (seen_by_snapshot(found)) {
+                retain(found, path_to);
+                found = step_over(found, path_to);
+                continue;
+            }
+            // found is the first node at or after val on every level of its tower
+            Node *next = found->next(0);
+            unlink(found, path_to);
+            found = next;
+        }
+        return count;
+    }
+
+    // Rank, Select
+    // Node at position index in key order, end() past the last node
+    Iterator at_rank(const size_t &index) {
+        if (index >= _size) {
+            return end();
+        }
+        Step *insert_after = _head;
+        size_t position = 0;
+        for (size_t level = _list_level + 1; level-- > 0;) {
+            // Stop on the last node counting at most index nodes, the next node on the first level counts index + 1
+            while (load(insert_after[level]) != nullptr && position + insert_after[level].width <= index) {
+                position += insert_after[level].width;
+                insert_after = Node::tower(load(insert_after[level]));
+            }
+        }
+        return Iterator(load(insert_after[0]));
+    }
+
+    // Number of nodes keyed below val, which is the position of lower_bound(val)
+    template<typename K = V>
+    size_t rank_of(const K &val) {
+        Step *path_to[MAX_LEVEL];
+        size_t rank[MAX_LEVEL];
+        find_path(lookup_key(val), path_to, false, rank);
+        return rank[0];
+    }
 
-        Node *insert_after = _head;
-        Node *lookup = insert_after->_list[_list_level];
+    // Nearest-rank percentile: the node at position ceil(fraction * size()) - 1, the first node for 0
+    Iterator percentile(const double &fraction) {
+        if (!(fraction >= 0.0 && fraction <= 1.0)) {
+            throw std::invalid_argument("SkipList::percentile(fraction) requires a fraction in [0, 1]");
+        }
+        const auto position = size_t(std::ceil(fraction * double(_size)));
+        return at_rank(position > 0 ? position - 1 : 0);
+    }
 
-        while (level != (unsigned long) -1) {
-            if (lookup == nullptr || val < lookup->_val) {
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    // Lookup keys are used as is by a transparent Compare, converted once to V otherwise
+    template<typename K>
+    static decltype(auto) lookup_key(const K &val) {
+        if constexpr (skiplist_detail::is_transparent<Compare>::value || std::is_same<K, V>::value) {
+            return (val);
+        } else {
+            return V(val);
+        }
+    }
+
+    // Fills path_to[level] with the tower holding the link to rewire at that level, _head standing for the list head,
+    // and rank[level] with the number of live nodes up to that tower when rank is given.
+    // Stops before the first node keyed at least val, or greater than val when after_equal; returns that node.
+    template<typename K>
+    Node *find_path(const K &val, Step *path_to[], const bool &after_equal, size_t rank[] = nullptr) {
+        size_t level = _list_level;
+        Step *insert_after = _head;
+        size_t position = 0;
+        while (true) {
+            Node *lookup = load(insert_after[level]);
+            if (lookup == nullptr || (after_equal ? _compare(val, lookup->_val) : !_compare(lookup->_val, val))) {
                 path_to[level] = insert_after;
+                if (rank != nullptr) {
+                    rank[level] = position;
+                }
+                if (level == 0) {
+                    return lookup;
+                }
                 level--;
             } else {
-                insert_after = lookup;
-                lookup = lookup->_list[level];
+                position += insert_after[level].width;
+                insert_after = Node::tower(lookup);
+            }
+        }
+    }
+
+    // Fills path_to[level] with the tower whose link reaches node on each level of node, and skips over it above
+    void find_links(Node *node, Step *path_to[]) {
+        Node *lookup = find_path(node->_val, path_to, false);
+        // Nodes sharing the key are only ordered by position, walk until node shows up
+        while (lookup != node) {
+            lookup = step_over(lookup, path_to);
+        }
+    }
+
+    // Fills tails[level] with the tower of the last node of each level and rank[level] with its position,
+    // returns the last node
+    Node *find_tails(Step *tails[], size_t rank[]) {
+        Step *insert_after = _head;
+        Node *last = nullptr;
+        size_t position = 0;
+        for (size_t level = MAX_LEVEL; level-- > 0;) {
+            while (load(insert_after[level]) != nullptr) {
+                position += insert_after[level].width;
+                last = load(insert_after[level]);
+                insert_after = Node::tower(last);
+            }
+            tails[level] = insert_after;
+            rank[level] = position;
+        }
+        return last;
+    }
+
+    // Sets the width of the last link of each level, which spans to the end of the list
+    void close_tails(Step *tails[], const size_t rank[]) {
+        for (size_t level = 0; level <= _list_level; ++level) {
+            tails[level][level].width = _size - rank[level];
+        }
+    }
+
+    // Recomputes every width in a single pass over the first level
+    void rebuild_widths() {
+        Step *tails[MAX_LEVEL];
+        size_t rank[MAX_LEVEL] = {};
+        std::fill(tails, tails + MAX_LEVEL, static_cast<Step *>(_head));
+        size_t position = 0;
+        for (Node *node = load(_head[0]); node != nullptr; node = node->next(0)) {
+            position += node->dead() ? 0 : 1;
+            for (size_t level = 0; level < node->_height; ++level) {
+                tails[level][level].width = position - rank[level];
+                tails[level] = Node::tower(node);
+                rank[level] = position;
             }
         }
-        new_node->_list.push_back(path_to[0]->_list[0]);
-        path_to[0]->_list[0] = new_node;
-        level = 1;
-        while (level <= _list_level && (rand() % _ratio) == 0) {
-            new_node->_list.push_back(path_to[level]->_list[level]);
-            path_to[level]->_list[level] = new_node;
-            level++;
+        close_tails(tails, rank);
+    }
+
+    // One level plus one per power of _ratio dividing index
+    size_t balanced_height(size_t index) const {
+        size_t height = 1;
+        while (height < MAX_LEVEL && _ratio > 1 && index % size_t(_ratio) == 0) {
+            index /= size_t(_ratio);
+            height++;
         }
-        if (level > _list_level && (rand() % _ratio) == 0) {
-            new_node->_list.push_back(nullptr);
-            _head->_list.push_back(new_node);
+        return height;
+    }
+
+    template<typename K>
+    Node *lower_bound_node(const K &val) {
+        Step *path_to[MAX_LEVEL];
+        return find_path(val, path_to, false);
+    }
+
+    // Links a new node at path_to and rank, found by find_path with the same after_equal
+    template<typename K, typename... Args>
+    void insert(Step *path_to[], size_t rank[], const bool &after_equal, K &&val, Args &&...args) {
+        const size_t height = random_height();
+        if (height > _list_level + 1) {
+            path_to[height - 1] = _head;
+            rank[height - 1] = 0;
+            _head[height - 1].width = _size;
             _list_level++;
         }
+        Node *new_node = create_node(height, std::forward<K>(val), std::forward<Args>(args)...);
+        for (size_t level = 0; level < height; ++level) {
+            Step &before = path_to[level][level];
+            // The new node comes right after rank[0] live nodes
+            const size_t skipped = rank[0] - rank[level];
+            new_node->width(level) = before.width - skipped;
+            before.width = skipped + 1;
+            new_node->link(level).store(load(before), std::memory_order_relaxed);
+            publish(before, new_node);
+        }
+        for (size_t level = height; level <= _list_level; ++level) {
+            path_to[level][level].width++;
+        }
+        // Everything before a node inserted ahead of _front is dead as well
+        if (_front != nullptr && (after_equal ? _compare(new_node->_val, _front->_val)
+                                              : !_compare(_front->_val, new_node->_val))) {
+            _front = new_node;
+        }
+        _size++;
     }
 
-    bool empty() const {
-        return _head->_list[0] == nullptr;
+    static Node *load(const Step &step) {
+        return step.next.load(std::memory_order_relaxed);
     }
 
-    T pop() {
-        T result = _head->_list[0]->_data;
-        Node *tmp = _head->_list[0];
-        for (size_t i = 0; i < tmp->_list.size(); ++i) {
-            _head->_list[i] = tmp->_list[i];
+    static void publish(Step &step, Node *node) {
+        step.next.store(node, std::memory_order_release);
+    }
+
+    static Node *skip_dead(Node *node) {
+        while (node != nullptr && node->dead()) {
+            node = node->next(0);
         }
-        delete tmp;
-        if (_head->_list[_list_level] == nullptr && _list_level > 0) {
+        return node;
+    }
+
+    // Every node before _front is dead, so the first live node is searched from there
+    Node *first_live() {
+        _front = skip_dead(_front != nullptr ? _front : load(_head[0]));
+        return _front;
+    }
+
+    // Moves path_to, and rank when given, past node, which must be the next node on level 0 from path_to.
+    // Returns the node after it.
+    static Node *step_over(Node *node, Step *path_to[], size_t rank[] = nullptr) {
+        const size_t position = rank == nullptr ? 0 : rank[0] + (node->dead() ? 0 : 1);
+        for (size_t level = 0; level < node->_height; ++level) {
+            path_to[level] = Node::tower(node);
+            if (rank != nullptr) {
+                rank[level] = position;
+            }
+        }
+        return node->next(0);
+    }
+
+    bool seen_by_snapshot(Node *node) const {
+        return _registry != nullptr && _registry->newest() >= node->_born;
+    }
+
+    // Hides node from the list, it stays linked until no snapshot sees it.
+    // path_to[level] holds the link reaching or skipping node on every level, as filled by find_links.
+    void retain(Node *node, Step *path_to[]) {
+        for (size_t level = 0; level <= _list_level; ++level) {
+            path_to[level][level].width--;
+        }
+        node->_died.store(_version, std::memory_order_relaxed);
+        _dead.push_back(node);
+        _size--;
+    }
+
+    // Unlinks node, path_to[level] holding the link reaching or skipping node on every level
+    void unlink(Node *node, Step *path_to[]) {
+        const size_t counted = node->dead() ? 0 : 1;
+        for (size_t level = 0; level < node->_height; ++level) {
+            Step &before = path_to[level][level];
+            before.width += node->width(level) - counted;
+            publish(before, node->next(level));
+        }
+        for (size_t level = node->_height; level <= _list_level; ++level) {
+            path_to[level][level].width -= counted;
+        }
+        _size -= counted;
+        if (_front == node) {
+            _front = node->next(0);
+        }
+        while (_list_level > 0 && load(_head[_list_level]) == nullptr) {
             _list_level--;
-            _head->_list.pop_back();
         }
-        return result;
+        // Readers of the snapshots held now may stand on node, it is freed once they are all released
+        if (_registry != nullptr && _registry->oldest() != SnapshotRegistry::NONE) {
+            _retired.emplace_back(node, _version);
+        } else {
+            destroy_node(node);
+        }
     }
 
-private:
-    Node *_head = {};
+    // Unlinks the dead nodes no snapshot sees anymore and frees the unlinked nodes no reader can reach
+    void collect() {
+        if (_registry == nullptr || (_dead.empty() && _retired.empty())) {
+            return;
+        }
+        const uint64_t oldest = _registry->oldest();
+        while (!_dead.empty() && _dead.front()->_died.load(std::memory_order_relaxed) <= oldest) {
+            Node *node = _dead.front();
+            _dead.pop_front();
+            Step *path_to[MAX_LEVEL];
+            find_links(node, path_to);
+            unlink(node, path_to);
+        }
+        while (!_retired.empty() && _retired.front().second <= oldest) {
+            destroy_node(_retired.front().first);
+            _retired.pop_front();
+        }
+    }
+
+    // Each level above the first is kept with probability 1 / _ratio, and at most one new level is opened
+    size_t random_height() {
+        const size_t limit = _list_level + 2 < MAX_LEVEL ? _list_level + 2 : MAX_LEVEL;
+        if (_ratio_bits != 0) {
+            // Every run of _ratio_bits zero bits is one promotion, so a single draw decides the whole tower
+            const size_t height = 1 + count_trailing_zeros(uint32_t(_random())) / _ratio_bits;
+            return height < limit ? height : limit;
+        }
+        size_t height = 1;
+        while (height < limit && (_random() % _ratio) == 0) {
+            height++;
+        }
+        return height;
+    }
+
+    static size_t count_trailing_zeros(const uint32_t &bits) {
+#if __cplusplus >= 202002L
+        return size_t(std::countr_zero(bits));
+#else
+        return bits == 0 ? 32 : size_t(__builtin_ctz(bits));
+#endif
+    }
+
+    template<typename K, typename... Args>
+    Node *create_node(const size_t &height, K &&val, Args &&...args) {
+        void *memory = _arena.allocate(height);
+        Node *node;
+        try {
+            node = new(memory) Node(height, std::forward<K>(val), std::forward<Args>(args)...);
+        } catch (...) {
+            _arena.deallocate(memory, height);
+            throw;
+        }
+        node->_born = _version;
+        for (size_t level = 0; level < height; ++level) {
+            node->link(level).store(nullptr, std::memory_order_relaxed);
+            node->width(level) = 0;
+        }
+        return node;
+    }
+
+    void destroy_node(Node *node) {
+        const size_t height = node->_height;
+        node->~Node();
+        _arena.deallocate(node, height);
+    }
+
+    Step _head[MAX_LEVEL] = {};
     size_t _list_level = {};
+    size_t _size = 0;
     int _ratio = 10;
+    // log2(_ratio) when _ratio is a power of two, 0 otherwise
+    size_t _ratio_bits = 0;
+    Random _random;
+    Compare _compare;
+    // Snapshots see the nodes born at or before their version and not dead at it
+    uint64_t _version = 1;
+    Node *_front = nullptr;
+    // Nodes hidden from the list in removal order, then unlinked nodes with the version they were unlinked at
+    std::deque<Node *> _dead = {};
+    std::deque<std::pair<Node *, uint64_t>> _retired = {};
+    std::unique_ptr<SnapshotRegistry> _registry = nullptr;
+    NodeArena _arena = {};
 };
 
 #endif //CPP_UTILS_SKIPLIST_H
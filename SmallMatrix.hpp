@@ -0,0 +1,590 @@
+//
+// Fixed-size matrix with inline storage, for 2x2 to 4x4 transforms and other small operands
+//
+// SmallMatrix has the element access, view and iteration interface of Matrix, so generic code and the matrix
+// algorithms accept both. Arithmetic is eager and constexpr, products are unrolled at compile time and
+// determinant/inverse use closed forms up to 4x4.
+//
+
+#ifndef CPP_UTILS_SMALLMATRIX_H
+#define CPP_UTILS_SMALLMATRIX_H
+
+#include <cstdlib> // size_t
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "Matrix.hpp"
+
+template<typename T, size_t W, size_t H>
+class SmallMatrix : public MatrixExpression<SmallMatrix<T, W, H>> {
+    static_assert(W > 0 && H > 0, "SmallMatrix requires non-zero dimensions");
+
+public:
+    using value_type = T;
+    using Iterator = MatrixIterator<T>;
+    using Const_Iterator = MatrixIterator<const T>;
+    using iterator = Iterator;
+    using const_iterator = Const_Iterator;
+
+    static constexpr size_t WIDTH = W;
+    static constexpr size_t HEIGHT = H;
+    static constexpr size_t SURFACE = W * H;
+
+    constexpr SmallMatrix() = default;
+    constexpr explicit SmallMatrix(const T &val);
+    // Row-major values, missing trailing values are value-initialized
+    constexpr SmallMatrix(std::initializer_list<T> values);
+    template<typename E>
+    explicit SmallMatrix(const MatrixExpression<E> &expr);
+
+    static constexpr SmallMatrix<T, W, H> identity();
+
+    constexpr SmallMatrix<T, W, H> &operator+=(const SmallMatrix<T, W, H> &other);
+    constexpr SmallMatrix<T, W, H> &operator-=(const SmallMatrix<T, W, H> &other);
+    constexpr SmallMatrix<T, W, H> &operator*=(const T &val);
+    constexpr SmallMatrix<T, W, H> &operator/=(const T &val);
+
+    constexpr const T &at(const size_t &x, const size_t &y) const;
+    constexpr T &at(const size_t &x, const size_t &y);
+
+    constexpr const T &at(const size_t &i) const;
+    constexpr T &at(const size_t &i);
+
+    constexpr size_t get_width() const;
+    constexpr size_t get_height() const;
+    constexpr size_t get_surface() const;
+
+    constexpr T *get_data();
+    constexpr const T *get_data() const;
+
+    bool aliases(const matrix_detail::StorageRegion &region) const;
+
+    MatrixView<T> view();
+    ConstMatrixView<T> view() const;
+    MatrixView<T> row(const size_t &y);
+    ConstMatrixView<T> row(const size_t &y) const;
+    MatrixView<T> column(const size_t &x);
+    ConstMatrixView<T> column(const size_t &x) const;
+    MatrixView<T> transposed();
+    ConstMatrixView<T> transposed() const;
+
+    operator MatrixView<T>();
+    operator ConstMatrixView<T>() const;
+
+    Iterator begin();
+    Const_Iterator begin() const;
+    Iterator end();
+    Const_Iterator end() const;
+    Const_Iterator cbegin() const;
+    Const_Iterator cend() const;
+    constexpr size_t size() const;
+
+private:
+    T data[W * H] = {};
+};
+
+template<typename T>
+using SmallMatrix2 = SmallMatrix<T, 2, 2>;
+
+template<typename T>
+using SmallMatrix3 = SmallMatrix<T, 3, 3>;
+
+template<typename T>
+using SmallMatrix4 = SmallMatrix<T, 4, 4>;
+
+namespace matrix_detail {
+
+    // Element (x, y) of lhs * rhs, the sum over k being expanded at compile time
+    template<typename T, size_t N, size_t W, size_t H, size_t... K>
+    constexpr T small_dot(const SmallMatrix<T, N, H> &lhs, const SmallMatrix<T, W, N> &rhs,
+                          const size_t &x, const size_t &y, std::index_sequence<K...>) {
+        return ((lhs.at(K, y) * rhs.at(x, K)) + ...);
+    }
+
+    template<typename T, size_t N, size_t W, size_t H, size_t... I>
+    constexpr SmallMatrix<T, W, H> small_multiply(const SmallMatrix<T, N, H> &lhs, const SmallMatrix<T, W, N> &rhs,
+                                                  std::index_sequence<I...>) {
+        SmallMatrix<T, W, H> result;
+        ((result.at(I) = small_dot(lhs, rhs, I % W, I / W, std::make_index_sequence<N>())), ...);
+        return result;
+    }
+
+    template<typename T>
+    constexpr T small_abs(const T &val) {
+        return val < T() ? -val : val;
+    }
+
+    // Gauss-Jordan elimination with partial pivoting on [mat | inv], returns the determinant of mat
+    template<typename T, size_t N>
+    constexpr T gauss_jordan(SmallMatrix<T, N, N> mat, SmallMatrix<T, N, N> *inv) {
+        T det = T(1);
+        for (size_t col = 0; col < N; ++col) {
+            size_t pivot = col;
+            for (size_t y = col + 1; y < N; ++y) {
+                if (small_abs(mat.at(col, y)) > small_abs(mat.at(col, pivot))) {
+                    pivot = y;
+                }
+            }
+            if (mat.at(col, pivot) == T()) {
+                return T();
+            }
+            if (pivot != col) {
+                det = -det;
+                for (size_t x = 0; x < N; ++x) {
+                    const T tmp = mat.at(x, col);
+                    mat.at(x, col) = mat.at(x, pivot);
+                    mat.at(x, pivot) = tmp;
+                    if (inv) {
+                        const T tmp_inv = inv->at(x, col);
+                        inv->at(x, col) = inv->at(x, pivot);
+                        inv->at(x, pivot) = tmp_inv;
+                    }
+                }
+            }
+            const T diag = mat.at(col, col);
+            det *= diag;
+            for (size_t y = 0; y < N; ++y) {
+                if (y == col || (!inv && y < col)) {
+                    continue;
+                }
+                const T factor = mat.at(col, y) / diag;
+                for (size_t x = 0; x < N; ++x) {
+                    mat.at(x, y) -= factor * mat.at(x, col);
+                    if (inv) {
+                        inv->at(x, y) -= factor * inv->at(x, col);
+                    }
+                }
+            }
+            if (inv) {
+                for (size_t x = 0; x < N; ++x) {
+                    mat.at(x, col) /= diag;
+                    inv->at(x, col) /= diag;
+                }
+            }
+        }
+        return det;
+    }
+}
+
+template<typename T, size_t W, size_t H>
+constexpr bool operator==(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs);
+
+template<typename T, size_t W, size_t H>
+constexpr bool operator!=(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs);
+
+// Eager overloads, preferred over the lazy MatrixExpression operators for SmallMatrix operands
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator+(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs);
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator-(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs);
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator-(const SmallMatrix<T, W, H> &mat);
+
+#define CPP_UTILS_SMALL_MATRIX_SCALAR_OPERATOR(OP)                                                                     \
+    template<typename T, size_t W, size_t H, typename S, matrix_detail::enable_if_scalar_t<S> = 0>                     \
+    constexpr SmallMatrix<T, W, H> operator OP(const SmallMatrix<T, W, H> &mat, const S &val) {                        \
+        SmallMatrix<T, W, H> result;                                                                                   \
+        for (size_t i = 0; i < W * H; ++i) {                                                                           \
+            result.at(i) = mat.at(i) OP T(val);                                                                        \
+        }                                                                                                              \
+        return result;                                                                                                 \
+    }                                                                                                                  \
+                                                                                                                       \
+    template<typename S, typename T, size_t W, size_t H, matrix_detail::enable_if_scalar_t<S> = 0>                     \
+    constexpr SmallMatrix<T, W, H> operator OP(const S &val, const SmallMatrix<T, W, H> &mat) {                        \
+        SmallMatrix<T, W, H> result;                                                                                   \
+        for (size_t i = 0; i < W * H; ++i) {                                                                           \
+            result.at(i) = T(val) OP mat.at(i);                                                                        \
+        }                                                                                                              \
+        return result;                                                                                                 \
+    }
+
+CPP_UTILS_SMALL_MATRIX_SCALAR_OPERATOR(+)
+CPP_UTILS_SMALL_MATRIX_SCALAR_OPERATOR(-)
+CPP_UTILS_SMALL_MATRIX_SCALAR_OPERATOR(*)
+CPP_UTILS_SMALL_MATRIX_SCALAR_OPERATOR(/)
+
+// Matrix product, lhs is N wide and rhs N high
+template<typename T, size_t N, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> multiply(const SmallMatrix<T, N, H> &lhs, const SmallMatrix<T, W, N> &rhs);
+
+template<typename T, size_t N, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator*(const SmallMatrix<T, N, H> &lhs, const SmallMatrix<T, W, N> &rhs);
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, H, W> transpose(const SmallMatrix<T, W, H> &mat);
+
+template<typename T, size_t N>
+constexpr T determinant(const SmallMatrix<T, N, N> &mat);
+
+template<typename T, size_t N>
+constexpr SmallMatrix<T, N, N> inverse(const SmallMatrix<T, N, N> &mat);
+
+// Functions definitions
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H>::SmallMatrix(const T &val) {
+    for (size_t i = 0; i < W * H; ++i) {
+        data[i] = val;
+    }
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H>::SmallMatrix(std::initializer_list<T> values) {
+    if (values.size() > W * H) {
+        throw std::invalid_argument("SmallMatrix<T, W, H>(values) requires at most W * H values");
+    }
+    size_t i = 0;
+    for (const T &val : values) {
+        data[i++] = val;
+    }
+}
+
+template<typename T, size_t W, size_t H>
+template<typename E>
+SmallMatrix<T, W, H>::SmallMatrix(const MatrixExpression<E> &expr) {
+    if (expr.get_width() != W || expr.get_height() != H) {
+        throw std::invalid_argument("SmallMatrix<T, W, H>(expr) requires expr to be W wide and H high");
+    }
+    for (size_t y = 0; y < H; ++y) {
+        for (size_t x = 0; x < W; ++x) {
+            data[y * W + x] = expr.at(x, y);
+        }
+    }
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> SmallMatrix<T, W, H>::identity() {
+    static_assert(W == H, "SmallMatrix<T, W, H>::identity() requires a square matrix");
+    SmallMatrix<T, W, H> result;
+    for (size_t i = 0; i < W; ++i) {
+        result.data[i * W + i] = T(1);
+    }
+    return result;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> &SmallMatrix<T, W, H>::operator+=(const SmallMatrix<T, W, H> &other) {
+    for (size_t i = 0; i < W * H; ++i) {
+        data[i] += other.data[i];
+    }
+    return *this;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> &SmallMatrix<T, W, H>::operator-=(const SmallMatrix<T, W, H> &other) {
+    for (size_t i = 0; i < W * H; ++i) {
+        data[i] -= other.data[i];
+    }
+    return *this;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> &SmallMatrix<T, W, H>::operator*=(const T &val) {
+    for (size_t i = 0; i < W * H; ++i) {
+        data[i] *= val;
+    }
+    return *this;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> &SmallMatrix<T, W, H>::operator/=(const T &val) {
+    for (size_t i = 0; i < W * H; ++i) {
+        data[i] /= val;
+    }
+    return *this;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr const T &SmallMatrix<T, W, H>::at(const size_t &x, const size_t &y) const {
+    return data[y * W + x];
+}
+
+template<typename T, size_t W, size_t H>
+constexpr T &SmallMatrix<T, W, H>::at(const size_t &x, const size_t &y) {
+    return data[y * W + x];
+}
+
+template<typename T, size_t W, size_t H>
+constexpr const T &SmallMatrix<T, W, H>::at(const size_t &i) const {
+    return data[i];
+}
+
+template<typename T, size_t W, size_t H>
+constexpr T &SmallMatrix<T, W, H>::at(const size_t &i) {
+    return data[i];
+}
+
+template<typename T, size_t W, size_t H>
+constexpr size_t SmallMatrix<T, W, H>::get_width() const {
+    return W;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr size_t SmallMatrix<T, W, H>::get_height() const {
+    return H;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr size_t SmallMatrix<T, W, H>::get_surface() const {
+    return W * H;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr T *SmallMatrix<T, W, H>::get_data() {
+    return data;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr const T *SmallMatrix<T, W, H>::get_data() const {
+    return data;
+}
+
+template<typename T, size_t W, size_t H>
+bool SmallMatrix<T, W, H>::aliases(const matrix_detail::StorageRegion &region) const {
+    return matrix_detail::regions_conflict(region, {data, W, H, ptrdiff_t(W), 1, sizeof(T)});
+}
+
+template<typename T, size_t W, size_t H>
+MatrixView<T> SmallMatrix<T, W, H>::view() {
+    return MatrixView<T>(data, W, H, W);
+}
+
+template<typename T, size_t W, size_t H>
+ConstMatrixView<T> SmallMatrix<T, W, H>::view() const {
+    return ConstMatrixView<T>(data, W, H, W);
+}
+
+template<typename T, size_t W, size_t H>
+MatrixView<T> SmallMatrix<T, W, H>::row(const size_t &y) {
+    return view().row(y);
+}
+
+template<typename T, size_t W, size_t H>
+ConstMatrixView<T> SmallMatrix<T, W, H>::row(const size_t &y) const {
+    return view().row(y);
+}
+
+template<typename T, size_t W, size_t H>
+MatrixView<T> SmallMatrix<T, W, H>::column(const size_t &x) {
+    return view().column(x);
+}
+
+template<typename T, size_t W, size_t H>
+ConstMatrixView<T> SmallMatrix<T, W, H>::column(const size_t &x) const {
+    return view().column(x);
+}
+
+template<typename T, size_t W, size_t H>
+MatrixView<T> SmallMatrix<T, W, H>::transposed() {
+    return view().transposed();
+}
+
+template<typename T, size_t W, size_t H>
+ConstMatrixView<T> SmallMatrix<T, W, H>::transposed() const {
+    return view().transposed();
+}
+
+template<typename T, size_t W, size_t H>
+SmallMatrix<T, W, H>::operator MatrixView<T>() {
+    return view();
+}
+
+template<typename T, size_t W, size_t H>
+SmallMatrix<T, W, H>::operator ConstMatrixView<T>() const {
+    return view();
+}
+
+template<typename T, size_t W, size_t H>
+typename SmallMatrix<T, W, H>::Iterator SmallMatrix<T, W, H>::begin() {
+    return Iterator(data);
+}
+
+template<typename T, size_t W, size_t H>
+typename SmallMatrix<T, W, H>::Const_Iterator SmallMatrix<T, W, H>::begin() const {
+    return Const_Iterator(data);
+}
+
+template<typename T, size_t W, size_t H>
+typename SmallMatrix<T, W, H>::Iterator SmallMatrix<T, W, H>::end() {
+    return Iterator(data + W * H);
+}
+
+template<typename T, size_t W, size_t H>
+typename SmallMatrix<T, W, H>::Const_Iterator SmallMatrix<T, W, H>::end() const {
+    return Const_Iterator(data + W * H);
+}
+
+template<typename T, size_t W, size_t H>
+typename SmallMatrix<T, W, H>::Const_Iterator SmallMatrix<T, W, H>::cbegin() const {
+    return begin();
+}
+
+template<typename T, size_t W, size_t H>
+typename SmallMatrix<T, W, H>::Const_Iterator SmallMatrix<T, W, H>::cend() const {
+    return end();
+}
+
+template<typename T, size_t W, size_t H>
+constexpr size_t SmallMatrix<T, W, H>::size() const {
+    return W * H;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr bool operator==(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs) {
+    for (size_t i = 0; i < W * H; ++i) {
+        if (!(lhs.at(i) == rhs.at(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr bool operator!=(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs) {
+    return !(lhs == rhs);
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator+(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs) {
+    SmallMatrix<T, W, H> result = lhs;
+    return result += rhs;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator-(const SmallMatrix<T, W, H> &lhs, const SmallMatrix<T, W, H> &rhs) {
+    SmallMatrix<T, W, H> result = lhs;
+    return result -= rhs;
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator-(const SmallMatrix<T, W, H> &mat) {
+    SmallMatrix<T, W, H> result;
+    for (size_t i = 0; i < W * H; ++i) {
+        result.at(i) = -mat.at(i);
+    }
+    return result;
+}
+
+template<typename T, size_t N, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> multiply(const SmallMatrix<T, N, H> &lhs, const SmallMatrix<T, W, N> &rhs) {
+    return matrix_detail::small_multiply(lhs, rhs, std::make_index_sequence<W * H>());
+}
+
+template<typename T, size_t N, size_t W, size_t H>
+constexpr SmallMatrix<T, W, H> operator*(const SmallMatrix<T, N, H> &lhs, const SmallMatrix<T, W, N> &rhs) {
+    return multiply(lhs, rhs);
+}
+
+template<typename T, size_t W, size_t H>
+constexpr SmallMatrix<T, H, W> transpose(const SmallMatrix<T, W, H> &mat) {
+    SmallMatrix<T, H, W> result;
+    for (size_t y = 0; y < H; ++y) {
+        for (size_t x = 0; x < W; ++x) {
+            result.at(y, x) = mat.at(x, y);
+        }
+    }
+    return result;
+}
+
+template<typename T, size_t N>
+constexpr T determinant(const SmallMatrix<T, N, N> &mat) {
+    const auto a = [&mat](const size_t &r, const size_t &c) { return mat.at(c, r); };
+    if constexpr (N == 1) {
+        return a(0, 0);
+    } else if constexpr (N == 2) {
+        return a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+    } else if constexpr (N == 3) {
+        return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1)) -
+               a(0, 1) * (a(1, 0) * a(2, 2) - a(1, 2) * a(2, 0)) +
+               a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+    } else if constexpr (N == 4) {
+        const T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+        const T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+        const T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+        const T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+        const T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+        const T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+        const T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+        const T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+        const T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+        const T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+        const T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+        const T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+        return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    } else {
+        return matrix_detail::gauss_jordan<T, N>(mat, nullptr);
+    }
+}
+
+template<typename T, size_t N>
+constexpr SmallMatrix<T, N, N> inverse(const SmallMatrix<T, N, N> &mat) {
+    const auto a = [&mat](const size_t &r, const size_t &c) { return mat.at(c, r); };
+    SmallMatrix<T, N, N> result;
+    // result.at(c, r) is the element at row r, column c
+    if constexpr (N == 1) {
+        if (a(0, 0) == T()) {
+            throw std::invalid_argument("inverse(mat) requires an invertible matrix");
+        }
+        result.at(0, 0) = T(1) / a(0, 0);
+    } else if constexpr (N == 2) {
+        const T det = determinant(mat);
+        if (det == T()) {
+            throw std::invalid_argument("inverse(mat) requires an invertible matrix");
+        }
+        result = {a(1, 1), -a(0, 1),
+                  -a(1, 0), a(0, 0)};
+        result /= det;
+    } else if constexpr (N == 3) {
+        const T c00 = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+        const T c01 = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+        const T c02 = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+        const T det = a(0, 0) * c00 + a(0, 1) * c01 + a(0, 2) * c02;
+        if (det == T()) {
+            throw std::invalid_argument("inverse(mat) requires an invertible matrix");
+        }
+        result = {c00, a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2), a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1),
+                  c01, a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0), a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2),
+                  c02, a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1), a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0)};
+        result /= det;
+    } else if constexpr (N == 4) {
+        const T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+        const T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+        const T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+        const T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+        const T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+        const T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+        const T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+        const T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+        const T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+        const T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+        const T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+        const T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+        const T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        if (det == T()) {
+            throw std::invalid_argument("inverse(mat) requires an invertible matrix");
+        }
+        result = {a(1, 1) * c5 - a(1, 2) * c4 + a(1, 3) * c3, -a(0, 1) * c5 + a(0, 2) * c4 - a(0, 3) * c3,
+                  a(3, 1) * s5 - a(3, 2) * s4 + a(3, 3) * s3, -a(2, 1) * s5 + a(2, 2) * s4 - a(2, 3) * s3,
+                  -a(1, 0) * c5 + a(1, 2) * c2 - a(1, 3) * c1, a(0, 0) * c5 - a(0, 2) * c2 + a(0, 3) * c1,
+                  -a(3, 0) * s5 + a(3, 2) * s2 - a(3, 3) * s1, a(2, 0) * s5 - a(2, 2) * s2 + a(2, 3) * s1,
+                  a(1, 0) * c4 - a(1, 1) * c2 + a(1, 3) * c0, -a(0, 0) * c4 + a(0, 1) * c2 - a(0, 3) * c0,
+                  a(3, 0) * s4 - a(3, 1) * s2 + a(3, 3) * s0, -a(2, 0) * s4 + a(2, 1) * s2 - a(2, 3) * s0,
+                  -a(1, 0) * c3 + a(1, 1) * c1 - a(1, 2) * c0, a(0, 0) * c3 - a(0, 1) * c1 + a(0, 2) * c0,
+                  -a(3, 0) * s3 + a(3, 1) * s1 - a(3, 2) * s0, a(2, 0) * s3 - a(2, 1) * s1 + a(2, 2) * s0};
+        result /= det;
+    } else {
+        result = SmallMatrix<T, N, N>::identity();
+        if (matrix_detail::gauss_jordan<T, N>(mat, &result) == T()) {
+            throw std::invalid_argument("inverse(mat) requires an invertible matrix");
+        }
+    }
+    return result;
+}
+
+#endif //CPP_UTILS_SMALLMATRIX_H
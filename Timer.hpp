@@ -23,6 +23,7 @@ public:
     Timer &display_ms(const std::string &message);
 
     long count_ms() const;
+    long long count_ns() const;
 private:
     std::chrono::time_point<std::chrono::system_clock> start_point;
     std::chrono::time_point<std::chrono::system_clock> stop_point;
@@ -44,6 +45,10 @@ long Timer::count_ms() const {
     return std::chrono::duration_cast<std::chrono::milliseconds>(stop_point - start_point).count();
 }
 
+long long Timer::count_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(stop_point - start_point).count();
+}
+
 Timer &Timer::display_ms() {
     std::cout << "\t---- Execution in " << count_ms() << " ms.\n";
     return *this;
@@ -0,0 +1,427 @@
+//
+// Skip list of sorted blocks: each bottom-level node holds up to B keys and their data in contiguous arrays
+//
+// Towers index blocks by their first key, so there is one tower per B elements instead of one per element.
+// Inside a block, arithmetic keys are located by counting smaller keys in a branch-free loop that vectorizes,
+// other keys by binary search. Full blocks split in two, sparse neighbours are merged back on removal.
+// T and V must be default constructible and move assignable.
+//
+
+#ifndef CPP_UTILS_UNROLLEDSKIPLIST_H
+#define CPP_UTILS_UNROLLEDSKIPLIST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <type_traits>
+#include <utility>
+
+#include "SkipList.h"
+
+template<typename T, typename V, size_t B = 32, typename Random = Xorshift64Star>
+class UnrolledSkipList {
+    static_assert(B >= 4, "UnrolledSkipList requires blocks of at least 4 elements");
+
+private:
+    static constexpr size_t MAX_LEVEL = 32;
+
+    // Block header and element arrays, its tower of _height next pointers follows it in the same allocation
+    class Block {
+    public:
+        explicit Block(const size_t &height) : _height(height) {}
+
+        ~Block() = default;
+
+        Block *&next(const size_t &level) {
+            return tower(this)[level];
+        }
+
+        static Block **tower(Block *block) {
+            return reinterpret_cast<Block **>(reinterpret_cast<char *>(block) + TOWER_OFFSET);
+        }
+
+        // Number of keys less than val, which is where val's lower bound is since keys are sorted
+        size_t lower_index(const V &val) const {
+            if constexpr (std::is_arithmetic<V>::value) {
+                size_t index = 0;
+                for (size_t i = 0; i < _count; ++i) {
+                    index += _keys[i] < val ? 1 : 0;
+                }
+                return index;
+            } else {
+                return size_t(std::lower_bound(_keys, _keys + _count, val) - _keys);
+            }
+        }
+
+        // Number of keys not greater than val
+        size_t upper_index(const V &val) const {
+            if constexpr (std::is_arithmetic<V>::value) {
+                size_t index = 0;
+                for (size_t i = 0; i < _count; ++i) {
+                    index += val < _keys[i] ? 0 : 1;
+                }
+                return index;
+            } else {
+                return size_t(std::upper_bound(_keys, _keys + _count, val) - _keys);
+            }
+        }
+
+        void insert(const size_t &index, const T &data, const V &val) {
+            std::move_backward(_keys + index, _keys + _count, _keys + _count + 1);
+            std::move_backward(_data + index, _data + _count, _data + _count + 1);
+            _keys[index] = val;
+            _data[index] = data;
+            _count++;
+        }
+
+        void remove(const size_t &first, const size_t &last) {
+            std::move(_keys + last, _keys + _count, _keys + first);
+            std::move(_data + last, _data + _count, _data + first);
+            _count -= last - first;
+        }
+
+        // Moves the elements [from, _count) to the end of other
+        void move_to(const size_t &from, Block *other) {
+            std::move(_keys + from, _keys + _count, other->_keys + other->_count);
+            std::move(_data + from, _data + _count, other->_data + other->_count);
+            other->_count += _count - from;
+            _count = from;
+        }
+
+        size_t _count = 0;
+        size_t _height = 0;
+        V _keys[B] = {};
+        T _data[B] = {};
+    };
+
+    static constexpr size_t TOWER_OFFSET = (sizeof(Block) + alignof(Block *) - 1) / alignof(Block *) * alignof(Block *);
+
+public:
+    class Iterator {
+    public:
+        Iterator(Block *at, const size_t &index) : _at(at), _index(index) {}
+
+        Iterator(const Iterator &other) = default;
+
+        ~Iterator() = default;
+
+        Iterator &operator++() {
+            if (++_index == _at->_count) {
+                _at = _at->next(0);
+                _index = 0;
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return _at == other._at && _index == other._index;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return !(*this == other);
+        }
+
+        T &operator*() {
+            return _at->_data[_index];
+        }
+
+        T *operator->() {
+            return &_at->_data[_index];
+        }
+
+        const V &key() const {
+            return _at->_keys[_index];
+        }
+
+    private:
+        Block *_at;
+        size_t _index;
+    };
+
+    // Half-open run of elements [begin, end), usable in range-based for loops
+    class Range {
+    public:
+        Range(const Iterator &begin, const Iterator &end) : _begin(begin), _end(end) {}
+
+        Iterator begin() const {
+            return _begin;
+        }
+
+        Iterator end() const {
+            return _end;
+        }
+
+    private:
+        Iterator _begin;
+        Iterator _end;
+    };
+
+public:
+    explicit UnrolledSkipList() : _random(std::random_device()()) {}
+
+    explicit UnrolledSkipList(const uint64_t &seed) : _random(seed) {}
+
+    UnrolledSkipList(const UnrolledSkipList &) = delete;
+
+    UnrolledSkipList &operator=(const UnrolledSkipList &) = delete;
+
+    ~UnrolledSkipList() {
+        Block *tmp = _head[0];
+        while (tmp != nullptr) {
+            Block *next = tmp->next(0);
+            destroy_block(tmp);
+            tmp = next;
+        }
+    }
+
+    Iterator begin() {
+        return Iterator(_head[0], 0);
+    }
+
+    Iterator end() {
+        return Iterator(nullptr, 0);
+    }
+
+    UnrolledSkipList &set_ratio(const int &ratio) {
+        _ratio = ratio;
+        return *this;
+    }
+
+    // Add, Pop
+    void add(const T &data, const V &val) {
+        Block **path_to[MAX_LEVEL];
+        Block *block = find_block(val, path_to, true);
+        if (block == nullptr) {
+            block = _head[0];
+            if (block == nullptr) {
+                block = create_block();
+                link_after(block, path_to);
+            }
+        }
+        size_t index = block->upper_index(val);
+        if (block->_count == B) {
+            Block *upper = split(block, path_to);
+            if (index > B / 2) {
+                index -= B / 2;
+                block = upper;
+            }
+        }
+        block->insert(index, data, val);
+        _size++;
+    }
+
+    bool empty() const {
+        return _head[0] == nullptr;
+    }
+
+    T pop() {
+        Block *first = _head[0];
+        T result = std::move(first->_data[0]);
+        first->remove(0, 1);
+        _size--;
+        if (first->_count == 0) {
+            // The first block is first on every level of its tower
+            for (size_t level = 0; level < first->_height; ++level) {
+                _head[level] = first->next(level);
+            }
+            destroy_block(first);
+            shrink_levels();
+        }
+        return result;
+    }
+
+    // Lookup, Erase
+    Iterator find(const V &val) {
+        Iterator found = lower_bound(val);
+        return found != end() && !(val < found.key()) ? found : end();
+    }
+
+    bool contains(const V &val) {
+        return find(val) != end();
+    }
+
+    // First element whose key is not less than val
+    Iterator lower_bound(const V &val) {
+        Block **path_to[MAX_LEVEL];
+        Block *block = find_block(val, path_to, false);
+        return position(block, block == nullptr ? 0 : block->lower_index(val));
+    }
+
+    // First element whose key is greater than val
+    Iterator upper_bound(const V &val) {
+        Block **path_to[MAX_LEVEL];
+        Block *block = find_block(val, path_to, true);
+        return position(block, block == nullptr ? 0 : block->upper_index(val));
+    }
+
+    // Elements keyed in [low, high)
+    Range range(const V &low, const V &high) {
+        Iterator first = lower_bound(low);
+        if (!(low < high)) {
+            return Range(first, first);
+        }
+        return Range(first, lower_bound(high));
+    }
+
+    // Removes every element keyed val, returns the number of removed elements
+    size_t erase(const V &val) {
+        size_t count = 0;
+        while (true) {
+            Block **path_to[MAX_LEVEL];
+            Block *block = find_block(val, path_to, false);
+            size_t first = block == nullptr ? 0 : block->lower_index(val);
+            if (block == nullptr || first == block->_count) {
+                block = block == nullptr ? _head[0] : block->next(0);
+                first = 0;
+            }
+            if (block == nullptr || val < block->_keys[first]) {
+                return count;
+            }
+            const size_t last = block->upper_index(val);
+            const V block_key = block->_keys[0];
+            block->remove(first, last);
+            count += last - first;
+            _size -= last - first;
+            rebalance(block, block_key);
+        }
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    // Fills path_to[level] with the tower of the last block on that level whose first key is less than val, or not
+    // greater than val when after_equal. _head stands for the list head. Returns the block reached on level 0,
+    // nullptr if val goes before every block.
+    Block *find_block(const V &val, Block **path_to[], const bool &after_equal) {
+        Block **insert_after = _head;
+        Block *block = nullptr;
+        for (size_t level = MAX_LEVEL; level-- > 0;) {
+            if (level <= _list_level) {
+                Block *lookup = insert_after[level];
+                while (lookup != nullptr && (after_equal ? !(val < lookup->_keys[0]) : lookup->_keys[0] < val)) {
+                    block = lookup;
+                    insert_after = Block::tower(lookup);
+                    lookup = insert_after[level];
+                }
+            }
+            path_to[level] = insert_after;
+        }
+        return block;
+    }
+
+    // Fills path_to[level] with the tower linking to block on each level of block, first_key being its first key
+    // when it was last linked
+    void find_links(Block *block, const V &first_key, Block **path_to[]) {
+        Block **insert_after = _head;
+        for (size_t level = block->_height; level-- > 0;) {
+            while (insert_after[level] != nullptr && insert_after[level] != block &&
+                   insert_after[level]->_keys[0] < first_key) {
+                insert_after = Block::tower(insert_after[level]);
+            }
+            // Blocks sharing the first key are only ordered by position, walk until block shows up
+            while (insert_after[level] != block) {
+                insert_after = Block::tower(insert_after[level]);
+            }
+            path_to[level] = insert_after;
+        }
+    }
+
+    Iterator position(Block *block, const size_t &index) {
+        if (block == nullptr) {
+            return begin();
+        }
+        if (index == block->_count) {
+            return Iterator(block->next(0), 0);
+        }
+        return Iterator(block, index);
+    }
+
+    // Moves the upper half of a full block into a new block linked right after it
+    Block *split(Block *block, Block **path_to[]) {
+        Block *upper = create_block();
+        Block **links[MAX_LEVEL];
+        for (size_t level = 0; level < upper->_height; ++level) {
+            links[level] = level < block->_height ? Block::tower(block) : path_to[level];
+        }
+        block->move_to(B / 2, upper);
+        link_after(upper, links);
+        return upper;
+    }
+
+    // Drops an emptied block, or merges it with its successor when both fit in half a block
+    void rebalance(Block *block, const V &block_key) {
+        Block **path_to[MAX_LEVEL];
+        if (block->_count == 0) {
+            find_links(block, block_key, path_to);
+            unlink(block, path_to);
+            return;
+        }
+        Block *next = block->next(0);
+        if (next != nullptr && block->_count + next->_count <= B / 2) {
+            find_links(next, next->_keys[0], path_to);
+            next->move_to(0, block);
+            unlink(next, path_to);
+        }
+    }
+
+    void link_after(Block *block, Block **path_to[]) {
+        for (size_t level = 0; level < block->_height; ++level) {
+            block->next(level) = path_to[level][level];
+            path_to[level][level] = block;
+        }
+    }
+
+    void unlink(Block *block, Block **path_to[]) {
+        for (size_t level = 0; level < block->_height; ++level) {
+            path_to[level][level] = block->next(level);
+        }
+        destroy_block(block);
+        shrink_levels();
+    }
+
+    void shrink_levels() {
+        while (_list_level > 0 && _head[_list_level] == nullptr) {
+            _list_level--;
+        }
+    }
+
+    // Blocks are created on splits only, so a plain draw per level is enough
+    Block *create_block() {
+        size_t height = 1;
+        while (height < MAX_LEVEL && height <= _list_level && (_random() % _ratio) == 0) {
+            height++;
+        }
+        if (height > _list_level && height < MAX_LEVEL && (_random() % _ratio) == 0) {
+            height++;
+        }
+        _list_level = height - 1 > _list_level ? height - 1 : _list_level;
+
+        void *memory = ::operator new(TOWER_OFFSET + height * sizeof(Block *));
+        Block *block;
+        try {
+            block = new(memory) Block(height);
+        } catch (...) {
+            ::operator delete(memory);
+            throw;
+        }
+        std::uninitialized_fill_n(Block::tower(block), height, nullptr);
+        return block;
+    }
+
+    void destroy_block(Block *block) {
+        block->~Block();
+        ::operator delete(block);
+    }
+
+    Block *_head[MAX_LEVEL] = {};
+    size_t _list_level = {};
+    size_t _size = 0;
+    int _ratio = 4;
+    Random _random;
+};
+
+#endif //CPP_UTILS_UNROLLEDSKIPLIST_H
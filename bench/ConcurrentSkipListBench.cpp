@@ -0,0 +1,204 @@
+//
+// Measures ConcurrentSkipList throughput from 1 to 64 threads against a mutex-guarded std::priority_queue
+//
+// Build from this directory:
+//   g++ -std=c++17 -O3 -DNDEBUG -pthread -I.. ConcurrentSkipListBench.cpp -o concurrent_skiplist_bench
+// Run ./concurrent_skiplist_bench --help for the options. Each queue is prefilled, then every thread runs its share
+// of --ops operations, alternating add and pop ("mixed") or, with half the threads adding and half popping
+// ("split"). Thread counts above the number of cores are oversubscribed, which is where lock-free progress should
+// show. Results are printed as throughput, and with --csv=path appended as CSV rows to path.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentSkipList.h"
+#include "ParseArg.h"
+#include "Timer.hpp"
+
+// Adapters exposing the two operations a workload needs, keys double as data
+class SkipListQueue {
+public:
+    explicit SkipListQueue(const bool &relaxed) : _relaxed(relaxed) {
+        _list.set_spread(32);
+    }
+
+    void add(const int64_t &key) {
+        _list.add(key, key);
+    }
+
+    bool pop(int64_t &key) {
+        return _relaxed ? _list.try_pop_relaxed(key) : _list.try_pop(key);
+    }
+
+private:
+    ConcurrentSkipList<int64_t, int64_t> _list;
+    bool _relaxed;
+};
+
+class LockedQueue {
+public:
+    explicit LockedQueue(const bool &) {}
+
+    void add(const int64_t &key) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push(key);
+    }
+
+    bool pop(int64_t &key) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_queue.empty()) {
+            return false;
+        }
+        key = _queue.top();
+        _queue.pop();
+        return true;
+    }
+
+private:
+    std::mutex _mutex;
+    std::priority_queue<int64_t, std::vector<int64_t>, std::greater<>> _queue;
+};
+
+struct Case {
+    std::string queue;
+    std::string workload;
+    int threads;
+};
+
+// Runs the case once, returns the elapsed nanoseconds for ops operations in total
+template<typename Queue>
+long long run(const Case &c, const size_t &ops, const size_t &prefill, const uint64_t &seed) {
+    Queue queue(c.queue == "skiplist_relaxed");
+    std::mt19937_64 random(seed);
+    for (size_t i = 0; i < prefill; ++i) {
+        queue.add(int64_t(random() >> 1));
+    }
+
+    const size_t per_thread = ops / size_t(c.threads);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < c.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 keys(seed + uint64_t(t) + 1);
+            // Split workloads pair adders with poppers, a lone thread does both
+            const bool adds = c.workload == "mixed" || c.threads == 1 || t % 2 == 0;
+            const bool pops = c.workload == "mixed" || c.threads == 1 || t % 2 == 1;
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            int64_t key;
+            for (size_t i = 0; i < per_thread; ++i) {
+                if (adds && (!pops || i % 2 == 0)) {
+                    queue.add(int64_t(keys() >> 1));
+                } else {
+                    queue.pop(key);
+                }
+            }
+        });
+    }
+    while (ready.load() < c.threads) {
+        std::this_thread::yield();
+    }
+    Timer timer;
+    timer.start();
+    go.store(true, std::memory_order_release);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    timer.stop();
+    return timer.count_ns();
+}
+
+long long run_case(const Case &c, const size_t &ops, const size_t &prefill, const uint64_t &seed) {
+    if (c.queue == "skiplist" || c.queue == "skiplist_relaxed") {
+        return run<SkipListQueue>(c, ops, prefill, seed);
+    } else if (c.queue == "locked_priority_queue") {
+        return run<LockedQueue>(c, ops, prefill, seed);
+    }
+    throw std::invalid_argument("Unknown queue '" + c.queue + "'");
+}
+
+std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    ParseArg args;
+    args.add_argument("threads", "--threads", "1,2,4,8,16,32,64");
+    args.add_argument("queues", "--queues", "skiplist,skiplist_relaxed,locked_priority_queue");
+    args.add_argument("workloads", "--workloads", "mixed,split");
+    args.add_argument("ops", "--ops", 2000000);
+    args.add_argument("prefill", "--prefill", 100000);
+    args.add_argument("repeat", "--repeat", 3);
+    args.add_argument("seed", "--seed", 42);
+    args.add_argument("label", "--label", "");
+    args.add_argument("csv", "--csv", "");
+    args.parse(argc, argv);
+
+    const auto ops = size_t(std::max(1, args["ops"].get_int()));
+    const auto prefill = size_t(std::max(0, args["prefill"].get_int()));
+    const int repeat = std::max(1, args["repeat"].get_int());
+    const auto seed = uint64_t(args["seed"].get_int());
+    const std::string label = args["label"].get_string();
+    const std::string csv_path = args["csv"].get_string();
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        const bool fresh = !std::ifstream(csv_path).good();
+        csv.open(csv_path, std::ios::app);
+        if (fresh) {
+            csv << "timestamp,label,queue,workload,threads,ops,ns_per_op,mops_per_s\n";
+        }
+    }
+    const long long timestamp = (long long) std::time(nullptr);
+
+    std::printf("%-22s %-8s %8s %12s %12s\n", "queue", "workload", "threads", "ns/op", "Mops/s");
+    for (const auto &workload : split(args["workloads"].get_string())) {
+        for (const auto &queue : split(args["queues"].get_string())) {
+            for (const auto &threads_text : split(args["threads"].get_string())) {
+                const Case c = {queue, workload, std::max(1, std::stoi(threads_text))};
+                const size_t total = ops / size_t(c.threads) * size_t(c.threads);
+                long long best = -1;
+                for (int i = 0; i < repeat; ++i) {
+                    const long long ns = run_case(c, ops, prefill, seed);
+                    best = best < 0 ? ns : std::min(best, ns);
+                }
+                const double ns_per_op = total == 0 ? 0.0 : double(best) / double(total);
+                const double mops_per_s = best == 0 ? 0.0 : double(total) * 1e3 / double(best);
+                std::printf("%-22s %-8s %8d %12.1f %12.2f\n", c.queue.c_str(), c.workload.c_str(), c.threads,
+                            ns_per_op, mops_per_s);
+                if (csv.is_open()) {
+                    csv << timestamp << ',' << label << ',' << c.queue << ',' << c.workload << ',' << c.threads << ','
+                        << total << ',' << ns_per_op << ',' << mops_per_s << '\n';
+                }
+                std::fflush(stdout);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+//
+// Measures how the MatrixAlgorithm reductions and transforms scale from one thread to every core
+//
+// Build from this directory:
+//   g++ -std=c++17 -O3 -march=native -fopenmp -DNDEBUG -I.. MatrixAlgorithmBench.cpp -o algorithm_bench
+// Run ./algorithm_bench --help for the options. Each kernel runs on the same float matrix with 1, 2, 4... threads up
+// to --max-threads (all cores by default). Results are printed as time, memory bandwidth and speedup over one thread,
+// and with --csv=path appended as CSV rows to path. Without OpenMP every run is single-threaded.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "MatrixAlgorithm.hpp"
+#include "ParseArg.h"
+#include "Timer.hpp"
+
+struct Kernel {
+    std::string name;
+    // Bytes read and written per element
+    size_t bytes;
+    std::function<void(const Matrix<float> &, Matrix<float> &)> run;
+};
+
+// Keeps results alive so the reductions are not optimized away
+static volatile double sink = 0;
+
+std::vector<Kernel> kernels() {
+    return {
+            {"sum", sizeof(float), [](const Matrix<float> &in, Matrix<float> &) {
+                sink = sum(in);
+            }},
+            {"minmax", sizeof(float), [](const Matrix<float> &in, Matrix<float> &) {
+                sink = minmax(in).second;
+            }},
+            {"argmax", sizeof(float), [](const Matrix<float> &in, Matrix<float> &) {
+                sink = double(argmax(in).x);
+            }},
+            {"count_if", sizeof(float), [](const Matrix<float> &in, Matrix<float> &) {
+                sink = double(count_if(in, [](const float &v) { return v > 0.5f; }));
+            }},
+            {"reduce", sizeof(float), [](const Matrix<float> &in, Matrix<float> &) {
+                sink = reduce(in, 0.0, [](const double &acc, const float &v) { return acc + double(v) * v; },
+                              std::plus<>());
+            }},
+            {"transform", 2 * sizeof(float), [](const Matrix<float> &in, Matrix<float> &out) {
+                transform(in, out, [](const float &v) { return std::sqrt(v); });
+            }},
+            {"apply", 2 * sizeof(float), [](const Matrix<float> &, Matrix<float> &out) {
+                apply(out, [](const size_t &, const size_t &, float &v) { v = v * 0.5f + 1.0f; });
+            }},
+    };
+}
+
+std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    ParseArg args;
+    args.add_argument("width", "--width", 8192);
+    args.add_argument("height", "--height", 8192);
+    args.add_argument("max_threads", "--max-threads", 0);
+    args.add_argument("kernels", "--kernels", "sum,minmax,argmax,count_if,reduce,transform,apply");
+    args.add_argument("repeat", "--repeat", 5);
+    args.add_argument("label", "--label", "");
+    args.add_argument("csv", "--csv", "");
+    args.parse(argc, argv);
+
+    const auto width = size_t(std::max(1, args["width"].get_int()));
+    const auto height = size_t(std::max(1, args["height"].get_int()));
+    const int repeat = std::max(1, args["repeat"].get_int());
+    const std::string label = args["label"].get_string();
+    const std::string csv_path = args["csv"].get_string();
+#ifdef _OPENMP
+    const int cores = omp_get_max_threads();
+#else
+    const int cores = 1;
+#endif
+    const int max_threads = args["max_threads"].get_int() > 0 ? args["max_threads"].get_int() : cores;
+
+    // Doubling thread counts, ending on max_threads itself
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        const bool fresh = !std::ifstream(csv_path).good();
+        csv.open(csv_path, std::ios::app);
+        if (fresh) {
+            csv << "timestamp,label,kernel,width,height,threads,ms,gb_per_s,speedup\n";
+        }
+    }
+    const long long timestamp = (long long) std::time(nullptr);
+
+    Matrix<float> in(width, height);
+    apply(in, [](const size_t &x, const size_t &y, float &v) { v = float((x * 7919 + y * 104729) % 1000) / 1000.0f; });
+    Matrix<float> out(width, height, 1.0f);
+
+    std::printf("%-10s %8s %12s %10s %9s\n", "kernel", "threads", "ms", "GB/s", "speedup");
+    const std::vector<std::string> selected = split(args["kernels"].get_string());
+    for (const auto &kernel : kernels()) {
+        if (std::find(selected.begin(), selected.end(), kernel.name) == selected.end()) {
+            continue;
+        }
+        long long single_ns = 0;
+        for (const int &threads : thread_counts) {
+#ifdef _OPENMP
+            omp_set_num_threads(threads);
+#endif
+            // One untimed run to fault pages in and start the thread pool
+            kernel.run(in, out);
+            long long best = -1;
+            for (int run = 0; run < repeat; ++run) {
+                Timer timer;
+                timer.start();
+                kernel.run(in, out);
+                timer.stop();
+                best = best < 0 ? timer.count_ns() : std::min(best, timer.count_ns());
+            }
+            if (threads == 1) {
+                single_ns = best;
+            }
+            const double bytes = double(width) * double(height) * double(kernel.bytes);
+            const double gb_per_s = best == 0 ? 0.0 : bytes / double(best);
+            const double speedup = best == 0 ? 0.0 : double(single_ns) / double(best);
+            std::printf("%-10s %8d %12.2f %10.2f %9.2f\n", kernel.name.c_str(), threads, double(best) / 1e6,
+                        gb_per_s, speedup);
+            if (csv.is_open()) {
+                csv << timestamp << ',' << label << ',' << kernel.name << ',' << width << ',' << height << ','
+                    << threads << ',' << double(best) / 1e6 << ',' << gb_per_s << ',' << speedup << '\n';
+            }
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+//
+// Benchmarks the MatrixLayout transposes and tiled layouts against plain row-major loops
+//
+// Build from this directory:
+//   g++ -std=c++17 -O3 -march=native -fopenmp -DNDEBUG -I.. MatrixLayoutBench.cpp -o layout_bench
+// Run ./layout_bench --help for the options. Sizes default to powers of two, where row-major columns collide in the
+// same cache sets, mixed with nearby sizes that are not. Transposes are compared with the naive double loop, the
+// tiled layouts with row-major storage on a 5-point neighborhood sum. Results are printed as time and bandwidth, and
+// with --csv=path appended as CSV rows to path.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MatrixLayout.hpp"
+#include "ParseArg.h"
+#include "Timer.hpp"
+
+// Keeps results alive so the kernels are not optimized away
+static volatile double sink = 0;
+
+template<typename M>
+double neighborhood_sum(const M &mat) {
+    const size_t width = mat.get_width();
+    const size_t height = mat.get_height();
+    const size_t last = height < 2 ? 1 : height - 1;
+    double total = 0;
+#pragma omp parallel for default(none) shared(mat, width, last) reduction(+ : total)
+    for (size_t y = 1; y < last; ++y) {
+        for (size_t x = 1; x + 1 < width; ++x) {
+            total += double(mat.at(x, y)) + mat.at(x - 1, y) + mat.at(x + 1, y) + mat.at(x, y - 1) + mat.at(x, y + 1);
+        }
+    }
+    return total;
+}
+
+struct Kernel {
+    std::string name;
+    // Bytes read and written per element
+    size_t bytes;
+    // Runs the kernel once on the input, returns its duration in nanoseconds
+    std::function<long long(const Matrix<float> &)> run;
+};
+
+template<typename F>
+long long timed(F &&f) {
+    Timer timer;
+    timer.start();
+    f();
+    timer.stop();
+    return timer.count_ns();
+}
+
+std::vector<Kernel> kernels() {
+    return {
+            {"naive_transpose", 2 * sizeof(float), [](const Matrix<float> &in) {
+                Matrix<float> out(in.get_height(), in.get_width(), Matrix<float>::uninitialized);
+                const size_t width = in.get_width();
+                const size_t height = in.get_height();
+                const long long ns = timed([&]() {
+#pragma omp parallel for default(none) shared(in, out, width, height)
+                    for (size_t y = 0; y < height; ++y) {
+                        for (size_t x = 0; x < width; ++x) {
+                            out.at(y, x) = in.at(x, y);
+                        }
+                    }
+                });
+                sink = out.at(0, 0);
+                return ns;
+            }},
+            {"transpose", 2 * sizeof(float), [](const Matrix<float> &in) {
+                Matrix<float> out;
+                const long long ns = timed([&]() { out = transpose(in); });
+                sink = out.at(0, 0);
+                return ns;
+            }},
+            {"transpose_in_place", 2 * sizeof(float), [](const Matrix<float> &in) {
+                if (in.get_width() != in.get_height()) {
+                    return 0LL;
+                }
+                Matrix<float> mat = in;
+                const long long ns = timed([&]() { transpose_in_place(mat); });
+                sink = mat.at(0, 0);
+                return ns;
+            }},
+            {"row_major_stencil", sizeof(float), [](const Matrix<float> &in) {
+                return timed([&]() { sink = neighborhood_sum(in); });
+            }},
+            {"block8_stencil", sizeof(float), [](const Matrix<float> &in) {
+                const TiledMatrix<float, BlockLayout<8>> tiled(in);
+                return timed([&]() { sink = neighborhood_sum(tiled); });
+            }},
+            {"morton64_stencil", sizeof(float), [](const Matrix<float> &in) {
+                const TiledMatrix<float, MortonLayout<64>> tiled(in);
+                return timed([&]() { sink = neighborhood_sum(tiled); });
+            }},
+            {"morton64_convert", 2 * sizeof(float), [](const Matrix<float> &in) {
+                return timed([&]() {
+                    const TiledMatrix<float, MortonLayout<64>> tiled(in);
+                    sink = tiled.at(0, 0);
+                });
+            }},
+    };
+}
+
+std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    ParseArg args;
+    args.add_argument("sizes", "--sizes", "1000,1024,2000,2048,4000,4096");
+    args.add_argument("kernels", "--kernels", "naive_transpose,transpose,transpose_in_place,row_major_stencil,"
+                                              "block8_stencil,morton64_stencil,morton64_convert");
+    args.add_argument("repeat", "--repeat", 3);
+    args.add_argument("label", "--label", "");
+    args.add_argument("csv", "--csv", "");
+    args.parse(argc, argv);
+
+    const int repeat = std::max(1, args["repeat"].get_int());
+    const std::string label = args["label"].get_string();
+    const std::string csv_path = args["csv"].get_string();
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        const bool fresh = !std::ifstream(csv_path).good();
+        csv.open(csv_path, std::ios::app);
+        if (fresh) {
+            csv << "timestamp,label,kernel,size,ms,gb_per_s\n";
+        }
+    }
+    const long long timestamp = (long long) std::time(nullptr);
+
+    const std::vector<std::string> selected = split(args["kernels"].get_string());
+    std::printf("%-20s %6s %12s %10s\n", "kernel", "size", "ms", "GB/s");
+    for (const auto &size_text : split(args["sizes"].get_string())) {
+        const auto size = size_t(std::stoul(size_text));
+        Matrix<float> in(size, size);
+        apply(in, [](const size_t &x, const size_t &y, float &v) { v = float((x * 31 + y * 17) % 251); });
+        for (const auto &kernel : kernels()) {
+            if (std::find(selected.begin(), selected.end(), kernel.name) == selected.end()) {
+                continue;
+            }
+            long long best = -1;
+            for (int run = 0; run < repeat; ++run) {
+                const long long ns = kernel.run(in);
+                best = best < 0 ? ns : std::min(best, ns);
+            }
+            const double bytes = double(size) * double(size) * double(kernel.bytes);
+            const double gb_per_s = best <= 0 ? 0.0 : bytes / double(best);
+            std::printf("%-20s %6zu %12.2f %10.2f\n", kernel.name.c_str(), size, double(best) / 1e6, gb_per_s);
+            if (csv.is_open()) {
+                csv << timestamp << ',' << label << ',' << kernel.name << ',' << size << ',' << double(best) / 1e6
+                    << ',' << gb_per_s << '\n';
+            }
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
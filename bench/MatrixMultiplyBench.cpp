@@ -0,0 +1,179 @@
+//
+// Benchmarks the blocked multiply against the naive triple loop
+//
+// Build from this directory:
+//   g++ -std=c++17 -O3 -march=native -fopenmp -DNDEBUG -I.. MatrixMultiplyBench.cpp -o multiply_bench
+// Run ./multiply_bench --help for the options. Both kernels multiply the same random square matrices, the naive loop
+// is skipped above --naive-max since it takes minutes at 4k. Results are printed as GFLOP/s, counting 2n^3 flops, and
+// with --csv=path appended as CSV rows to path.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "MatrixMultiply.hpp"
+#include "ParseArg.h"
+#include "Timer.hpp"
+
+// i-k-j order, so the inner loop streams rows of rhs and result
+template<typename T>
+Matrix<T> naive_multiply(const Matrix<T> &lhs, const Matrix<T> &rhs) {
+    const size_t m = lhs.get_height(), n = rhs.get_width(), k = lhs.get_width();
+    Matrix<T> result(n, m, T());
+    const T *a = lhs.get_data();
+    const T *b = rhs.get_data();
+    T *c = result.get_data();
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t p = 0; p < k; ++p) {
+            const T scale = a[i * k + p];
+            for (size_t j = 0; j < n; ++j) {
+                c[i * n + j] += scale * b[p * n + j];
+            }
+        }
+    }
+    return result;
+}
+
+template<typename T>
+Matrix<T> random_matrix(const size_t &size, std::mt19937_64 &random) {
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    Matrix<T> result(size, size);
+    for (size_t i = 0; i < size * size; ++i) {
+        result.get_data()[i] = T(distribution(random));
+    }
+    return result;
+}
+
+template<typename T>
+double max_difference(const Matrix<T> &lhs, const Matrix<T> &rhs) {
+    double difference = 0.0;
+    for (size_t i = 0; i < lhs.get_surface(); ++i) {
+        difference = std::max(difference, std::abs(double(lhs.get_data()[i]) - double(rhs.get_data()[i])));
+    }
+    return difference;
+}
+
+// Best of repeat runs, in nanoseconds
+template<typename F>
+long long best_time(const int &repeat, F &&run) {
+    long long best = -1;
+    for (int i = 0; i < repeat; ++i) {
+        Timer timer;
+        timer.start();
+        run();
+        timer.stop();
+        best = best < 0 ? timer.count_ns() : std::min(best, timer.count_ns());
+    }
+    return best;
+}
+
+struct Result {
+    std::string kernel;
+    long long ns;
+};
+
+template<typename T>
+std::vector<Result> run_size(const size_t &size, const int &repeat, const size_t &naive_max, const uint64_t &seed) {
+    std::mt19937_64 random(seed);
+    const Matrix<T> lhs = random_matrix<T>(size, random);
+    const Matrix<T> rhs = random_matrix<T>(size, random);
+    std::vector<Result> results;
+
+    Matrix<T> blocked(0, 0);
+    results.push_back({"blocked", best_time(repeat, [&]() { blocked = multiply(lhs, rhs); })});
+    if (size <= naive_max) {
+        Matrix<T> naive(0, 0);
+        results.push_back({"naive", best_time(repeat, [&]() { naive = naive_multiply(lhs, rhs); })});
+        // Both sum the same products in a different order
+        const double difference = max_difference(blocked, naive);
+        if (difference > 1e-3 * double(size)) {
+            throw std::runtime_error("blocked and naive results differ by " + std::to_string(difference));
+        }
+    }
+    return results;
+}
+
+std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    ParseArg args;
+    args.add_argument("sizes", "--sizes", "1024,2048,3072,4096");
+    args.add_argument("types", "--types", "float,double");
+    args.add_argument("naive_max", "--naive-max", 2048);
+    args.add_argument("repeat", "--repeat", 3);
+    args.add_argument("seed", "--seed", 42);
+    args.add_argument("label", "--label", "");
+    args.add_argument("csv", "--csv", "");
+    args.parse(argc, argv);
+
+    const int repeat = std::max(1, args["repeat"].get_int());
+    const auto naive_max = size_t(std::max(0, args["naive_max"].get_int()));
+    const auto seed = uint64_t(args["seed"].get_int());
+    const std::string label = args["label"].get_string();
+    const std::string csv_path = args["csv"].get_string();
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        const bool fresh = !std::ifstream(csv_path).good();
+        csv.open(csv_path, std::ios::app);
+        if (fresh) {
+            csv << "timestamp,label,type,size,kernel,ms,gflops,speedup\n";
+        }
+    }
+    const long long timestamp = (long long) std::time(nullptr);
+
+    std::printf("%-8s %6s %-8s %12s %10s %9s\n", "type", "size", "kernel", "ms", "GFLOP/s", "speedup");
+    for (const auto &size_text : split(args["sizes"].get_string())) {
+        const auto size = size_t(std::stoul(size_text));
+        for (const auto &type : split(args["types"].get_string())) {
+            std::vector<Result> results;
+            if (type == "float") {
+                results = run_size<float>(size, repeat, naive_max, seed);
+            } else if (type == "double") {
+                results = run_size<double>(size, repeat, naive_max, seed);
+            } else {
+                throw std::invalid_argument("Unknown type '" + type + "'");
+            }
+            // Speedup of each kernel over the naive loop, when it ran
+            long long naive_ns = 0;
+            for (const auto &r : results) {
+                if (r.kernel == "naive") {
+                    naive_ns = r.ns;
+                }
+            }
+            const double flops = 2.0 * double(size) * double(size) * double(size);
+            for (const auto &r : results) {
+                const double gflops = r.ns == 0 ? 0.0 : flops / double(r.ns);
+                const double speedup = naive_ns == 0 || r.ns == 0 ? 0.0 : double(naive_ns) / double(r.ns);
+                std::printf("%-8s %6zu %-8s %12.1f %10.2f %9.2f\n", type.c_str(), size, r.kernel.c_str(),
+                            double(r.ns) / 1e6, gflops, speedup);
+                if (csv.is_open()) {
+                    csv << timestamp << ',' << label << ',' << type << ',' << size << ',' << r.kernel << ','
+                        << double(r.ns) / 1e6 << ',' << gflops << ',' << speedup << '\n';
+                }
+            }
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+//
+// Benchmarks the MatrixStencil correlation and morphology against naive per-pixel loops
+//
+// Build from this directory:
+//   g++ -std=c++17 -O3 -march=native -fopenmp -DNDEBUG -I.. MatrixStencilBench.cpp -o stencil_bench
+// Run ./stencil_bench --help for the options. Each kernel size runs a dense random kernel through convolve(), a
+// Gaussian through convolve() (detected as separable) and convolve_separable(), and erode(), each next to a naive loop
+// clamping every tap. Results are checked against the naive loop and printed as time and speedup, and with
+// --csv=path appended as CSV rows to path.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MatrixStencil.hpp"
+#include "ParseArg.h"
+#include "Timer.hpp"
+
+size_t clamp_index(const ptrdiff_t &i, const size_t &size) {
+    return size_t(std::min(std::max(i, ptrdiff_t(0)), ptrdiff_t(size) - 1));
+}
+
+// Correlation with the anchor at the kernel center and clamped borders, as convolve(src, kernel, Border::Clamp)
+Matrix<float> naive_convolve(const Matrix<float> &src, const Matrix<float> &kernel) {
+    const size_t width = src.get_width();
+    const size_t height = src.get_height();
+    const auto ax = ptrdiff_t(kernel.get_width() / 2);
+    const auto ay = ptrdiff_t(kernel.get_height() / 2);
+    Matrix<float> result(width, height);
+#pragma omp parallel for default(none) shared(src, kernel, result, width, height, ax, ay)
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            float acc = 0;
+            for (size_t j = 0; j < kernel.get_height(); ++j) {
+                const size_t sy = clamp_index(ptrdiff_t(y + j) - ay, height);
+                for (size_t i = 0; i < kernel.get_width(); ++i) {
+                    acc += kernel.at(i, j) * src.at(clamp_index(ptrdiff_t(x + i) - ax, width), sy);
+                }
+            }
+            result.at(x, y) = acc;
+        }
+    }
+    return result;
+}
+
+Matrix<float> naive_erode(const Matrix<float> &src, const size_t &size) {
+    const size_t width = src.get_width();
+    const size_t height = src.get_height();
+    const auto anchor = ptrdiff_t(size / 2);
+    Matrix<float> result(width, height);
+#pragma omp parallel for default(none) shared(src, result, width, height, size, anchor)
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            float low = src.at(x, y);
+            for (size_t j = 0; j < size; ++j) {
+                const size_t sy = clamp_index(ptrdiff_t(y + j) - anchor, height);
+                for (size_t i = 0; i < size; ++i) {
+                    low = std::min(low, src.at(clamp_index(ptrdiff_t(x + i) - anchor, width), sy));
+                }
+            }
+            result.at(x, y) = low;
+        }
+    }
+    return result;
+}
+
+std::vector<float> gaussian_taps(const size_t &size) {
+    std::vector<float> taps(size);
+    const double sigma = double(size) / 4.0;
+    double total = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const double d = double(i) - double(size / 2);
+        taps[i] = float(std::exp(-d * d / (2 * sigma * sigma)));
+        total += taps[i];
+    }
+    for (auto &tap : taps) {
+        tap = float(tap / total);
+    }
+    return taps;
+}
+
+double max_difference(const Matrix<float> &lhs, const Matrix<float> &rhs) {
+    double difference = 0;
+    for (size_t i = 0; i < lhs.get_surface(); ++i) {
+        difference = std::max(difference, std::abs(double(lhs.at(i)) - double(rhs.at(i))));
+    }
+    return difference;
+}
+
+// Best of repeat runs in nanoseconds, result holds the output of the last one
+template<typename F>
+long long best_time(const int &repeat, Matrix<float> &result, F &&run) {
+    long long best = -1;
+    for (int i = 0; i < repeat; ++i) {
+        Timer timer;
+        timer.start();
+        result = run();
+        timer.stop();
+        best = best < 0 ? timer.count_ns() : std::min(best, timer.count_ns());
+    }
+    return best;
+}
+
+struct Result {
+    std::string kernel;
+    long long ns;
+    long long naive_ns;
+};
+
+std::vector<Result> run_size(const Matrix<float> &src, const size_t &taps, const int &repeat, std::mt19937 &random) {
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    Matrix<float> dense(taps, taps);
+    for (size_t i = 0; i < dense.get_surface(); ++i) {
+        dense.at(i) = distribution(random);
+    }
+    const std::vector<float> gaussian = gaussian_taps(taps);
+    Matrix<float> separable(taps, taps);
+    for (size_t j = 0; j < taps; ++j) {
+        for (size_t i = 0; i < taps; ++i) {
+            separable.at(i, j) = gaussian[i] * gaussian[j];
+        }
+    }
+
+    std::vector<Result> results;
+    Matrix<float> fast, naive;
+    const auto check = [&](const char *name, const double &tolerance) {
+        const double difference = max_difference(fast, naive);
+        if (difference > tolerance) {
+            throw std::runtime_error(std::string(name) + " differs from the naive loop by " +
+                                     std::to_string(difference));
+        }
+    };
+
+    long long naive_ns = best_time(repeat, naive, [&]() { return naive_convolve(src, dense); });
+    results.push_back({"convolve_dense", best_time(repeat, fast, [&]() { return convolve(src, dense); }), naive_ns});
+    check("convolve_dense", 1e-3 * double(taps * taps));
+
+    naive_ns = best_time(repeat, naive, [&]() { return naive_convolve(src, separable); });
+    results.push_back({"convolve_gaussian", best_time(repeat, fast, [&]() { return convolve(src, separable); }),
+                       naive_ns});
+    check("convolve_gaussian", 1e-3);
+    results.push_back({"convolve_separable",
+                       best_time(repeat, fast, [&]() { return convolve_separable(src, gaussian, gaussian); }),
+                       naive_ns});
+    check("convolve_separable", 1e-3);
+
+    naive_ns = best_time(repeat, naive, [&]() { return naive_erode(src, taps); });
+    results.push_back({"erode", best_time(repeat, fast, [&]() { return erode(src, taps, taps); }), naive_ns});
+    check("erode", 0);
+    return results;
+}
+
+std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    ParseArg args;
+    args.add_argument("sizes", "--sizes", "1024,2048,4096");
+    args.add_argument("taps", "--taps", "3,5,9,15");
+    args.add_argument("repeat", "--repeat", 3);
+    args.add_argument("seed", "--seed", 42);
+    args.add_argument("label", "--label", "");
+    args.add_argument("csv", "--csv", "");
+    args.parse(argc, argv);
+
+    const int repeat = std::max(1, args["repeat"].get_int());
+    const std::string label = args["label"].get_string();
+    const std::string csv_path = args["csv"].get_string();
+    std::mt19937 random(uint32_t(args["seed"].get_int()));
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        const bool fresh = !std::ifstream(csv_path).good();
+        csv.open(csv_path, std::ios::app);
+        if (fresh) {
+            csv << "timestamp,label,kernel,size,taps,ms,naive_ms,speedup\n";
+        }
+    }
+    const long long timestamp = (long long) std::time(nullptr);
+
+    std::printf("%-20s %6s %5s %12s %12s %9s\n", "kernel", "size", "taps", "ms", "naive ms", "speedup");
+    for (const auto &size_text : split(args["sizes"].get_string())) {
+        const auto size = size_t(std::stoul(size_text));
+        std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+        Matrix<float> src(size, size);
+        for (size_t i = 0; i < src.get_surface(); ++i) {
+            src.at(i) = distribution(random);
+        }
+        for (const auto &taps_text : split(args["taps"].get_string())) {
+            const auto taps = size_t(std::stoul(taps_text));
+            for (const auto &r : run_size(src, taps, repeat, random)) {
+                const double speedup = r.ns == 0 ? 0.0 : double(r.naive_ns) / double(r.ns);
+                std::printf("%-20s %6zu %5zu %12.2f %12.2f %9.2f\n", r.kernel.c_str(), size, taps,
+                            double(r.ns) / 1e6, double(r.naive_ns) / 1e6, speedup);
+                if (csv.is_open()) {
+                    csv << timestamp << ',' << label << ',' << r.kernel << ',' << size << ',' << taps << ','
+                        << double(r.ns) / 1e6 << ',' << double(r.naive_ns) / 1e6 << ',' << speedup << '\n';
+                }
+            }
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
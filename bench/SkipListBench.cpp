@@ -0,0 +1,442 @@
+//
+// Benchmarks SkipList against the standard ordered containers
+//
+// Build from this directory:
+//   g++ -std=c++17 -O3 -DNDEBUG -I.. SkipListBench.cpp -o skiplist_bench
+// Run ./skiplist_bench --help for the options. Every case runs in its own process on POSIX systems, so its peak RSS
+// is measured alone. Results are printed as a table and, with --csv=path, appended as CSV rows to path.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SKIPLIST_BENCH_FORK 1
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "ParseArg.h"
+#include "SkipList.h"
+#include "Timer.hpp"
+#include "UnrolledSkipList.h"
+
+// Adapters exposing the operations a workload needs, keys double as data
+class SkipListAdapter {
+public:
+    SkipListAdapter(const uint64_t &seed, const int &ratio) : _list(seed) {
+        _list.set_ratio(ratio);
+    }
+
+    void insert(const int64_t &key) {
+        _list.add(key, key);
+    }
+
+    int64_t pop_min() {
+        return _list.pop();
+    }
+
+    bool contains(const int64_t &key) {
+        return _list.contains(key);
+    }
+
+    int64_t sum() {
+        int64_t total = 0;
+        for (auto it = _list.begin(); it != _list.end(); ++it) {
+            total += *it;
+        }
+        return total;
+    }
+
+    size_t size() const {
+        return _list.size();
+    }
+
+    static constexpr bool ORDERED = true;
+
+private:
+    SkipList<int64_t, int64_t> _list;
+};
+
+class UnrolledSkipListAdapter {
+public:
+    UnrolledSkipListAdapter(const uint64_t &seed, const int &ratio) : _list(seed) {
+        _list.set_ratio(ratio);
+    }
+
+    void insert(const int64_t &key) {
+        _list.add(key, key);
+    }
+
+    int64_t pop_min() {
+        return _list.pop();
+    }
+
+    bool contains(const int64_t &key) {
+        return _list.contains(key);
+    }
+
+    int64_t sum() {
+        int64_t total = 0;
+        for (auto it = _list.begin(); it != _list.end(); ++it) {
+            total += *it;
+        }
+        return total;
+    }
+
+    size_t size() const {
+        return _list.size();
+    }
+
+    static constexpr bool ORDERED = true;
+
+private:
+    UnrolledSkipList<int64_t, int64_t> _list;
+};
+
+// std::map keeps a single element per key, duplicated keys are dropped on insert
+template<typename Map>
+class MapAdapter {
+public:
+    MapAdapter(const uint64_t &, const int &) {}
+
+    void insert(const int64_t &key) {
+        _map.emplace(key, key);
+    }
+
+    int64_t pop_min() {
+        const int64_t result = _map.begin()->second;
+        _map.erase(_map.begin());
+        return result;
+    }
+
+    bool contains(const int64_t &key) {
+        return _map.find(key) != _map.end();
+    }
+
+    int64_t sum() {
+        int64_t total = 0;
+        for (const auto &element : _map) {
+            total += element.second;
+        }
+        return total;
+    }
+
+    size_t size() const {
+        return _map.size();
+    }
+
+    static constexpr bool ORDERED = true;
+
+private:
+    Map _map;
+};
+
+class PriorityQueueAdapter {
+public:
+    PriorityQueueAdapter(const uint64_t &, const int &) {}
+
+    void insert(const int64_t &key) {
+        _queue.push(key);
+    }
+
+    int64_t pop_min() {
+        const int64_t result = _queue.top();
+        _queue.pop();
+        return result;
+    }
+
+    bool contains(const int64_t &) {
+        return false;
+    }
+
+    int64_t sum() {
+        return 0;
+    }
+
+    size_t size() const {
+        return _queue.size();
+    }
+
+    // No lookup nor ordered iteration
+    static constexpr bool ORDERED = false;
+
+private:
+    std::priority_queue<int64_t, std::vector<int64_t>, std::greater<>> _queue;
+};
+
+struct Case {
+    std::string container;
+    std::string distribution;
+    int ratio;
+    size_t size;
+};
+
+struct Result {
+    std::string workload;
+    size_t ops;
+    long long ns;
+};
+
+// Keys of a distribution, the same for every container given the seed
+std::vector<int64_t> make_keys(const std::string &distribution, const size_t &size, const uint64_t &seed) {
+    std::vector<int64_t> keys(size);
+    std::mt19937_64 random(seed);
+    if (distribution == "uniform") {
+        for (auto &key : keys) {
+            key = int64_t(random() >> 1);
+        }
+    } else if (distribution == "sorted" || distribution == "reversed") {
+        for (size_t i = 0; i < size; ++i) {
+            keys[i] = int64_t(distribution == "sorted" ? i : size - i);
+        }
+    } else if (distribution == "duplicates") {
+        // About 16 copies of every key
+        const uint64_t range = size / 16 + 1;
+        for (auto &key : keys) {
+            key = int64_t(random() % range);
+        }
+    } else {
+        throw std::invalid_argument("Unknown key distribution '" + distribution + "'");
+    }
+    return keys;
+}
+
+template<typename Adapter>
+std::vector<Result> run_workloads(const Case &c, const size_t &max_ops, const uint64_t &seed) {
+    const std::vector<int64_t> keys = make_keys(c.distribution, c.size, seed);
+    std::mt19937_64 random(seed ^ 0x5bd1e995u);
+    std::vector<Result> results;
+    Timer timer;
+    int64_t sink = 0;
+
+    Adapter container(seed, c.ratio);
+    timer.start();
+    for (const auto &key : keys) {
+        container.insert(key);
+    }
+    timer.stop();
+    results.push_back({"insert", keys.size(), timer.count_ns()});
+
+    const size_t ops = std::min(max_ops, keys.size());
+    if (Adapter::ORDERED) {
+        std::vector<int64_t> probes(ops);
+        for (auto &probe : probes) {
+            probe = keys[random() % keys.size()];
+        }
+        timer.start();
+        for (const auto &probe : probes) {
+            sink += container.contains(probe);
+        }
+        timer.stop();
+        results.push_back({"find", ops, timer.count_ns()});
+
+        timer.start();
+        sink += container.sum();
+        timer.stop();
+        results.push_back({"iterate", container.size(), timer.count_ns()});
+    }
+
+    // Steady-state priority queue use: every pop is followed by an insert slightly above the popped key. std::map
+    // drops colliding inserts, so it may run dry
+    std::vector<int64_t> gaps(ops);
+    for (auto &gap : gaps) {
+        gap = int64_t(random() % (keys.size() + 1));
+    }
+    timer.start();
+    for (const auto &gap : gaps) {
+        if (container.size() == 0) {
+            break;
+        }
+        container.insert(container.pop_min() + gap);
+    }
+    timer.stop();
+    results.push_back({"mixed", ops, timer.count_ns()});
+
+    // std::map may hold fewer elements than keys
+    const size_t remaining = container.size();
+    timer.start();
+    for (size_t i = 0; i < remaining; ++i) {
+        sink += container.pop_min();
+    }
+    timer.stop();
+    results.push_back({"pop_min", remaining, timer.count_ns()});
+
+    // Keeps the work observable
+    if (sink == 42) {
+        std::cerr << "";
+    }
+    return results;
+}
+
+std::vector<Result> run_case(const Case &c, const size_t &max_ops, const uint64_t &seed) {
+    if (c.container == "skiplist") {
+        return run_workloads<SkipListAdapter>(c, max_ops, seed);
+    } else if (c.container == "unrolled_skiplist") {
+        return run_workloads<UnrolledSkipListAdapter>(c, max_ops, seed);
+    } else if (c.container == "map") {
+        return run_workloads<MapAdapter<std::map<int64_t, int64_t>>>(c, max_ops, seed);
+    } else if (c.container == "multimap") {
+        return run_workloads<MapAdapter<std::multimap<int64_t, int64_t>>>(c, max_ops, seed);
+    } else if (c.container == "priority_queue") {
+        return run_workloads<PriorityQueueAdapter>(c, max_ops, seed);
+    }
+    throw std::invalid_argument("Unknown container '" + c.container + "'");
+}
+
+// Runs the best of repeat runs, in a child process when possible; peak_rss_kb is 0 when unknown
+std::vector<Result> measure(const Case &c, const size_t &max_ops, const uint64_t &seed, const int &repeat,
+                            long &peak_rss_kb) {
+    std::vector<Result> best;
+    peak_rss_kb = 0;
+    for (int run = 0; run < repeat; ++run) {
+        std::vector<Result> results;
+#ifdef SKIPLIST_BENCH_FORK
+        int channel[2];
+        if (pipe(channel) != 0) {
+            throw std::runtime_error("pipe() failed");
+        }
+        std::cout.flush();
+        const pid_t child = fork();
+        if (child == 0) {
+            close(channel[0]);
+            std::ostringstream out;
+            for (const auto &r : run_case(c, max_ops, seed)) {
+                out << r.workload << ' ' << r.ops << ' ' << r.ns << '\n';
+            }
+            const std::string text = out.str();
+            size_t written = 0;
+            while (written < text.size()) {
+                const ssize_t n = write(channel[1], text.data() + written, text.size() - written);
+                if (n <= 0) {
+                    _exit(1);
+                }
+                written += size_t(n);
+            }
+            _exit(0);
+        }
+        close(channel[1]);
+        std::string text;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(channel[0], buffer, sizeof(buffer))) > 0) {
+            text.append(buffer, size_t(n));
+        }
+        close(channel[0]);
+        int status = 0;
+        struct rusage usage = {};
+        if (child < 0 || wait4(child, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw std::runtime_error("Benchmark case " + c.container + " failed");
+        }
+        // ru_maxrss is in bytes on macOS, in KiB elsewhere
+#ifdef __APPLE__
+        peak_rss_kb = std::max(peak_rss_kb, long(usage.ru_maxrss / 1024));
+#else
+        peak_rss_kb = std::max(peak_rss_kb, long(usage.ru_maxrss));
+#endif
+        std::istringstream in(text);
+        Result r;
+        while (in >> r.workload >> r.ops >> r.ns) {
+            results.push_back(r);
+        }
+#else
+        results = run_case(c, max_ops, seed);
+#endif
+        if (best.empty()) {
+            best = results;
+        } else {
+            for (size_t i = 0; i < best.size() && i < results.size(); ++i) {
+                best[i].ns = std::min(best[i].ns, results[i].ns);
+            }
+        }
+    }
+    return best;
+}
+
+std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> items;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+int main(int argc, char **argv) {
+    ParseArg args;
+    args.add_argument("sizes", "--sizes", "1000,100000,1000000");
+    args.add_argument("containers", "--containers", "skiplist,unrolled_skiplist,map,multimap,priority_queue");
+    args.add_argument("distributions", "--distributions", "uniform,sorted,reversed,duplicates");
+    args.add_argument("ratios", "--ratios", "2,4,10");
+    args.add_argument("repeat", "--repeat", 3);
+    args.add_argument("max_ops", "--max-ops", 1000000);
+    args.add_argument("seed", "--seed", 42);
+    args.add_argument("label", "--label", "");
+    args.add_argument("csv", "--csv", "");
+    args.parse(argc, argv);
+
+    const int repeat = std::max(1, args["repeat"].get_int());
+    const auto max_ops = size_t(std::max(1, args["max_ops"].get_int()));
+    const auto seed = uint64_t(args["seed"].get_int());
+    const std::string label = args["label"].get_string();
+    const std::string csv_path = args["csv"].get_string();
+
+    std::ofstream csv;
+    if (!csv_path.empty()) {
+        const bool fresh = !std::ifstream(csv_path).good();
+        csv.open(csv_path, std::ios::app);
+        if (fresh) {
+            csv << "timestamp,label,container,ratio,distribution,size,workload,ops,ns_per_op,ops_per_s,peak_rss_kb\n";
+        }
+    }
+    const long long timestamp = (long long) std::time(nullptr);
+
+    std::printf("%-18s %5s %-10s %10s %-8s %12s %14s %12s\n", "container", "ratio", "keys", "size", "workload",
+                "ns/op", "ops/s", "peak RSS kB");
+    for (const auto &size_text : split(args["sizes"].get_string())) {
+        const auto size = size_t(std::stod(size_text));
+        for (const auto &distribution : split(args["distributions"].get_string())) {
+            for (const auto &container : split(args["containers"].get_string())) {
+                // Only the skip lists have a ratio to tune
+                std::vector<std::string> ratios = {"0"};
+                if (container == "skiplist" || container == "unrolled_skiplist") {
+                    ratios = split(args["ratios"].get_string());
+                }
+                for (const auto &ratio : ratios) {
+                    const Case c = {container, distribution, std::stoi(ratio), size};
+                    long peak_rss_kb = 0;
+                    for (const auto &r : measure(c, max_ops, seed, repeat, peak_rss_kb)) {
+                        const double ns_per_op = r.ops == 0 ? 0.0 : double(r.ns) / double(r.ops);
+                        const double ops_per_s = r.ns == 0 ? 0.0 : double(r.ops) * 1e9 / double(r.ns);
+                        std::printf("%-18s %5d %-10s %10zu %-8s %12.1f %14.0f %12ld\n", c.container.c_str(), c.ratio,
+                                    c.distribution.c_str(), c.size, r.workload.c_str(), ns_per_op, ops_per_s,
+                                    peak_rss_kb);
+                        if (csv.is_open()) {
+                            csv << timestamp << ',' << label << ',' << c.container << ',' << c.ratio << ','
+                                << c.distribution << ',' << c.size << ',' << r.workload << ',' << r.ops << ','
+                                << ns_per_op << ',' << ops_per_s << ',' << peak_rss_kb << '\n';
+                        }
+                    }
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+//
+// Concurrent producers and consumers on one ConcurrentSkipList: every added element must be popped exactly once
+//
+// Build from this directory, with either sanitizer:
+//   g++ -std=c++17 -O1 -g -fsanitize=thread -pthread -I.. ConcurrentSkipListStressTest.cpp -o csl_stress
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -pthread -I.. ConcurrentSkipListStressTest.cpp -o csl_stress
+// Exits with a non-zero status on the first failed check.
+//
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentSkipList.h"
+
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while (false)
+
+constexpr int THREADS = 6;
+constexpr int PER_THREAD = 20000;
+
+int main() {
+    ConcurrentSkipList<int, int> list;
+    list.set_spread(8);
+    std::vector<std::atomic<int>> seen(THREADS * PER_THREAD);
+    std::atomic<int> popped{0};
+
+    // Every thread adds its own range, with colliding keys, and pops along the way, half of them relaxed
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            int data;
+            for (int i = 0; i < PER_THREAD; ++i) {
+                const int id = t * PER_THREAD + i;
+                list.add(id, id % 1000);
+                if (i % 2 == 1 && (t % 2 == 0 ? list.try_pop(data) : list.try_pop_relaxed(data))) {
+                    seen[data].fetch_add(1, std::memory_order_relaxed);
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    CHECK(list.size() == size_t(THREADS * PER_THREAD - popped.load()));
+
+    // What is left drains in key order
+    int data;
+    int previous_key = -1;
+    while (list.try_pop(data)) {
+        CHECK(data % 1000 >= previous_key);
+        previous_key = data % 1000;
+        seen[data].fetch_add(1, std::memory_order_relaxed);
+    }
+    CHECK(list.empty());
+    for (const std::atomic<int> &count : seen) {
+        CHECK(count.load() == 1);
+    }
+
+    std::puts("ConcurrentSkipListStressTest passed");
+    return 0;
+}
@@ -0,0 +1,58 @@
+//
+// Checks that the MatrixAlgorithm reductions give the same results whatever the number of threads
+//
+// Build from this directory, with or without OpenMP:
+//   g++ -std=c++17 -O2 -fopenmp -I.. MatrixAlgorithmTest.cpp -o matrix_algorithm_test
+// Exits with a non-zero status on the first failed check.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "MatrixAlgorithm.hpp"
+
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while (false)
+
+void check_reductions() {
+    const Matrix<int> twos(3, 3, 2);
+    // op transforms every element, combine only merges partials
+    CHECK(reduce(twos, 0, [](const int &acc, const int &v) { return acc + v * v; }, std::plus<>()) == 36);
+    CHECK(reduce(twos, 0, [](const int &acc, const int &) { return acc + 1; }, std::plus<>()) == 9);
+    CHECK(reduce(twos, 5, [](const long &acc, const int &v) { return acc + v; }, std::plus<>()) == 23);
+    // op also merges partials, init is folded once and needs no identity
+    CHECK(reduce(twos, 1, std::multiplies<>()) == 512);
+    CHECK(reduce(twos, 8, std::plus<>()) == 26);
+    CHECK(reduce(Matrix<int>(0, 0), 7, std::plus<>()) == 7);
+
+    Matrix<int> values(5, 7);
+    apply(values, [](const size_t &x, const size_t &y, int &v) { v = int(x * 7 + y); });
+    CHECK(sum(values) == 595);
+    CHECK(count_if(values, [](const int &v) { return v % 2 == 0; }) == 18);
+    CHECK(argmax(values).x == 4 && argmax(values).y == 6);
+    CHECK(reduce(values.transposed(), 0, [](const int &acc, const int &v) { return acc + v * v; }, std::plus<>()) ==
+          reduce(values, 0, [](const int &acc, const int &v) { return acc + v * v; }, std::plus<>()));
+}
+
+int main() {
+#ifdef _OPENMP
+    for (const int threads : {1, 2, 3, 4, 8}) {
+        omp_set_num_threads(threads);
+        check_reductions();
+    }
+#else
+    check_reductions();
+#endif
+    std::puts("MatrixAlgorithmTest passed");
+    return 0;
+}
@@ -0,0 +1,103 @@
+//
+// Checks that assigning an expression reading its own destination at other coordinates gives the aliasing-free result
+//
+// Build from this directory:
+//   g++ -std=c++17 -O2 -fopenmp -I.. MatrixAliasingTest.cpp -o matrix_aliasing_test
+// Exits with a non-zero status on the first failed check.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+#include "Matrix.hpp"
+#include "SmallMatrix.hpp"
+
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while (false)
+
+// Views assign their elements, which const views cannot, while copying a view of either kind rebinds it
+static_assert(std::is_copy_assignable<MatrixView<int>>::value, "MatrixView assigns elements");
+static_assert(!std::is_copy_assignable<ConstMatrixView<int>>::value, "ConstMatrixView cannot assign elements");
+static_assert(std::is_copy_constructible<ConstMatrixView<int>>::value, "ConstMatrixView copies as a view");
+
+Matrix<int> numbered(const size_t &width, const size_t &height) {
+    Matrix<int> result(width, height);
+    for (size_t i = 0; i < result.get_surface(); ++i) {
+        result.at(i) = int(i);
+    }
+    return result;
+}
+
+template<typename A, typename B>
+bool equal(const A &lhs, const B &rhs) {
+    for (size_t y = 0; y < lhs.get_height(); ++y) {
+        for (size_t x = 0; x < lhs.get_width(); ++x) {
+            if (lhs.at(x, y) != rhs.at(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    const Matrix<int> original = numbered(64, 64);
+
+    // Detection: same-coordinate reads are safe, anything else overlapping is not
+    Matrix<int> a = original;
+    const matrix_detail::StorageRegion whole = {a.get_data(), 64, 64, 64, 1, sizeof(int)};
+    CHECK(!matrix_detail::aliases(a * 2 + 1, whole));
+    CHECK(!matrix_detail::aliases(original + original, whole));
+    CHECK(matrix_detail::aliases(a.transposed(), whole));
+    CHECK(matrix_detail::aliases(original.view(0, 0, 63, 64) + map(a.view(1, 0, 63, 64), [](int v) { return v; }),
+                                 {a.get_data(), 63, 64, 64, 1, sizeof(int)}));
+
+    a = a.transposed();
+    CHECK(equal(a, original.transposed()));
+
+    a = original;
+    a = a + a.transposed();
+    CHECK(equal(a, original + original.transposed()));
+
+    a = original;
+    a += a.transposed();
+    CHECK(equal(a, original + original.transposed()));
+
+    a = original;
+    a = a * 2 + 1;
+    CHECK(equal(a, original * 2 + 1));
+
+    // Views over the same matrix
+    a = original;
+    MatrixView<int> square = a.view(8, 8, 32, 32);
+    square = square.transposed();
+    CHECK(equal(square, original.view(8, 8, 32, 32).transposed()));
+    CHECK(equal(a.view(0, 0, 64, 8), original.view(0, 0, 64, 8)));
+
+    a = original;
+    a.view(0, 0, 40, 40) = a.view(1, 1, 40, 40);
+    CHECK(equal(a.view(0, 0, 40, 40), original.view(1, 1, 40, 40)));
+
+    a = original;
+    a.view(1, 1, 40, 40) = a.view(0, 0, 40, 40);
+    CHECK(equal(a.view(1, 1, 40, 40), original.view(0, 0, 40, 40)));
+
+    a = original;
+    a.row(3) = a.column(5).transposed();
+    CHECK(equal(a.row(3), original.column(5).transposed()));
+
+    // Other storage owners seen through a view
+    SmallMatrix<int, 4, 4> small = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    const SmallMatrix<int, 4, 4> small_original = small;
+    small.view() = small.transposed();
+    CHECK(equal(small, small_original.transposed()));
+
+    std::puts("MatrixAliasingTest passed");
+    return 0;
+}
@@ -0,0 +1,85 @@
+//
+// Checks that Matrix expressions evaluate in one pass, without temporaries
+//
+// Build from this directory:
+//   g++ -std=c++17 -O2 -I.. MatrixExpressionTest.cpp -o matrix_expression_test
+// Exits with a non-zero status on the first failed check.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+#include "AlignedAllocator.hpp"
+#include "Matrix.hpp"
+
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while (false)
+
+static size_t allocations = 0;
+
+// Counts every buffer the matrices request, so an expression building temporaries shows up
+template<typename T>
+class CountingAllocator : public AlignedAllocator<T> {
+public:
+    template<typename U>
+    struct rebind {
+        using other = CountingAllocator<U>;
+    };
+
+    CountingAllocator() noexcept = default;
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U> &) noexcept {}
+
+    T *allocate(const size_t &n) {
+        ++allocations;
+        return AlignedAllocator<T>::allocate(n);
+    }
+};
+
+using CountedMatrix = Matrix<int, CountingAllocator<int>>;
+
+int main() {
+    CountedMatrix a(64, 32, 1);
+    CountedMatrix b(64, 32, 2);
+    CountedMatrix c(64, 32, 3);
+
+    // Constructing from an expression allocates the result and nothing else
+    allocations = 0;
+    CountedMatrix r = a + b * 2 - hadamard(c, c) + map(a, [](int v) { return v * 10; });
+    CHECK(allocations == 1);
+    CHECK(r.at(5, 7) == 1 + 4 - 9 + 10);
+
+    // Assigning an expression of the same dimensions reuses the buffer
+    allocations = 0;
+    r = -a + c * 3;
+    r += hadamard(b, b);
+    r -= a / 1;
+    CHECK(allocations == 0);
+    CHECK(r.at(63, 31) == -1 + 9 + 4 - 1);
+
+    // Other dimensions need a single new buffer
+    CountedMatrix small(8, 8, 5);
+    allocations = 0;
+    r = small + small;
+    CHECK(allocations == 1);
+    CHECK(r.get_width() == 8 && r.get_height() == 8 && r.at(3, 3) == 10);
+
+    // Conversions that may narrow must be spelled out
+    static_assert(std::is_convertible<Matrix<float>, Matrix<double>>::value, "float widens to double");
+    static_assert(std::is_convertible<Matrix<char>, Matrix<char>>::value, "same element type");
+    static_assert(!std::is_convertible<Matrix<double>, Matrix<int>>::value, "double narrows to int");
+    static_assert(std::is_constructible<Matrix<int>, Matrix<double>>::value, "explicit conversion");
+    Matrix<double> d(4, 4, 2.75);
+    Matrix<int> i(d);
+    CHECK(i.at(2, 2) == 2);
+
+    std::puts("MatrixExpressionTest passed");
+    return 0;
+}
@@ -0,0 +1,107 @@
+//
+// Round-trips matrices and views through save_matrix, load_matrix and MappedMatrix, and rejects corrupted headers
+//
+// Build from this directory:
+//   g++ -std=c++17 -O2 -I.. MatrixFileTest.cpp -o matrix_file_test
+// Writes its scratch files to the working directory and removes them. Exits with a non-zero status on the first
+// failed check.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "MatrixFile.hpp"
+
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if (!(cond)) {                                                                    \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while (false)
+
+const std::string PATH = "matrix_file_test.cpmx";
+const std::string COPY_PATH = "matrix_file_test_copy.cpmx";
+
+template<typename A, typename B>
+bool same_elements(const A &lhs, const B &rhs) {
+    if (lhs.get_width() != rhs.get_width() || lhs.get_height() != rhs.get_height()) {
+        return false;
+    }
+    for (size_t y = 0; y < lhs.get_height(); ++y) {
+        for (size_t x = 0; x < lhs.get_width(); ++x) {
+            if (lhs.at(x, y) != rhs.at(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<typename F>
+bool throws(F &&f) {
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+// Rewrites the width and height of the header saved at path
+void patch_dimensions(const std::string &path, const uint64_t &width, const uint64_t &height) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(std::streamoff(offsetof(matrix_detail::FileHeader, width)));
+    file.write(reinterpret_cast<const char *>(&width), sizeof(width));
+    file.write(reinterpret_cast<const char *>(&height), sizeof(height));
+}
+
+int main() {
+    Matrix<float> mat(7, 5);
+    apply(mat, [](const size_t &x, const size_t &y, float &v) { v = float(x) * 10.0f + float(y); });
+
+    // Matrices, strided views and transposes are all saved without naming the element type
+    save_matrix(PATH, mat);
+    CHECK(same_elements(load_matrix<float>(PATH), mat));
+    save_matrix(PATH, mat.view(2, 1, 4, 3));
+    CHECK(same_elements(load_matrix<float>(PATH), mat.view(2, 1, 4, 3)));
+    save_matrix(PATH, mat.transposed());
+    CHECK(same_elements(load_matrix<float>(PATH), mat.transposed()));
+    save_matrix<float>(PATH, mat);
+    CHECK(same_elements(load_matrix<float>(PATH), mat));
+
+    // Mappings read the same elements, and are saved like any matrix
+    {
+        const MappedMatrix<float> mapped = Matrix<float>::map_file(PATH);
+        CHECK(same_elements(mapped, mat));
+        save_matrix(COPY_PATH, mapped);
+        CHECK(same_elements(load_matrix<float>(COPY_PATH), mat));
+
+        MappedMatrix<float> private_copy(COPY_PATH, MatrixMapMode::CopyOnWrite);
+        private_copy.mutable_view().at(0, 0) = -1.0f;
+        CHECK(private_copy.at(0, 0) == -1.0f);
+        CHECK(load_matrix<float>(COPY_PATH).at(0, 0) == mat.at(0, 0));
+    }
+
+    // Wrong element types and truncated or overflowing dimensions are rejected before any allocation
+    CHECK(throws([]() { load_matrix<double>(PATH); }));
+    patch_dimensions(COPY_PATH, 7, 6);
+    CHECK(throws([]() { load_matrix<float>(COPY_PATH); }));
+    CHECK(throws([]() { MappedMatrix<float> mapped(COPY_PATH); }));
+    patch_dimensions(COPY_PATH, uint64_t(1) << 62, 4);
+    CHECK(throws([]() { load_matrix<float>(COPY_PATH); }));
+    CHECK(throws([]() { MappedMatrix<float> mapped(COPY_PATH); }));
+    patch_dimensions(COPY_PATH, uint64_t(1) << 32, uint64_t(1) << 32);
+    CHECK(throws([]() { load_matrix<float>(COPY_PATH); }));
+    CHECK(throws([]() { MappedMatrix<float> mapped(COPY_PATH); }));
+
+    std::remove(PATH.c_str());
+    std::remove(COPY_PATH.c_str());
+    std::puts("MatrixFileTest passed");
+    return 0;
+}